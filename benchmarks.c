@@ -0,0 +1,250 @@
+// quick and dirty micro benchmarks, to have actual numbers to compare
+// before and after touching the containers used in the hot paths.
+
+#include "vector.h"
+#include "maps.h"
+#include "transforms.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// how many times every benchmark is run, the best time is kept
+#define BENCH_RUNS 5
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// run `body` BENCH_RUNS times and print the best time in ms
+#define BENCH(name, body) { \
+    double best = -1; \
+    for(int __r = 0; __r < BENCH_RUNS; __r++) { \
+        double start = now(); \
+        body \
+        double t = now() - start; \
+        best = best < 0 || t < best ? t : best; \
+    } \
+    printf("  %-48s %9.3f ms\n", name, best * 1000); \
+}
+
+// used to make sure the compiler doesn't optimise the loops away
+volatile float sink;
+
+void bench_vectors() {
+    const int count = 4000000;
+    // a text object appends 12 floats per glyph
+    const int chunks = 200000;
+    float chunk[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    printf("vectors (%i floats pushed, %i chunks of 12 floats appended)\n", count, chunks);
+
+    BENCH("Vector       push", {
+        Vector v;
+        vector_init(&v, 2, sizeof(float));
+        for(int i = 0; i < count; i++) {
+            float f = i;
+            vector_push(&v, &f);
+        }
+        vector_free(v);
+    })
+    BENCH("Vector_float push", {
+        Vector_float v;
+        vector_float_init(&v, 2);
+        for(int i = 0; i < count; i++) {
+            vector_float_push(&v, i);
+        }
+        vector_float_free(v);
+    })
+    BENCH("Vector       push_array", {
+        Vector v;
+        vector_init(&v, 2, sizeof(float));
+        for(int i = 0; i < chunks; i++) {
+            vector_push_array(&v, chunk, 12);
+        }
+        vector_free(v);
+    })
+    BENCH("Vector_float push_array", {
+        Vector_float v;
+        vector_float_init(&v, 2);
+        for(int i = 0; i < chunks; i++) {
+            vector_float_push_array(&v, chunk, 12);
+        }
+        vector_float_free(v);
+    })
+
+    Vector gv;
+    Vector_float tv;
+    vector_init(&gv, count, sizeof(float));
+    vector_float_init(&tv, count);
+    for(int i = 0; i < count; i++) {
+        float f = i;
+        vector_push(&gv, &f);
+        vector_float_push(&tv, f);
+    }
+    BENCH("Vector       get (vector_get_pointer_to)", {
+        float sum = 0;
+        for(int i = 0; i < count; i++) {
+            sum += *(float*)vector_get_pointer_to(gv, i);
+        }
+        sink = sum;
+    })
+    BENCH("Vector_float get", {
+        float sum = 0;
+        for(int i = 0; i < count; i++) {
+            sum += vector_float_get(&tv, i);
+        }
+        sink = sum;
+    })
+    BENCH("Vector       set", {
+        for(int i = 0; i < count; i++) {
+            float f = i;
+            vector_set(&gv, &f, i);
+        }
+    })
+    BENCH("Vector_float set", {
+        for(int i = 0; i < count; i++) {
+            vector_float_set(&tv, i, i);
+        }
+    })
+    vector_free(gv);
+    vector_float_free(tv);
+}
+
+void bench_small_vectors() {
+    // what a GlhProgram's uniforms, a map or an event broadcaster looks like
+    const int count = 1000000;
+    char* names[2] = {"MVP", "uTexture"};
+    printf("small vectors (%i create, push 2 pointers, walk, free)\n", count);
+
+    BENCH("Vector", {
+        for(int i = 0; i < count; i++) {
+            Vector v;
+            vector_init(&v, 2, sizeof(char*));
+            vector_push_array(&v, names, 2);
+            sink = vector_get(v.data, 1, char*)[0];
+            vector_free(v);
+        }
+    })
+    BENCH("SmallVector", {
+        for(int i = 0; i < count; i++) {
+            SmallVector v;
+            small_vector_init(&v, sizeof(char*));
+            small_vector_push_array(&v, names, 2);
+            sink = vector_get(small_vector_data(&v), 1, char*)[0];
+            small_vector_free(&v);
+        }
+    })
+}
+
+// what map lookups used to be, a strcmp against every key
+int linearKeyIndex(char** keys, int count, char* key) {
+    for(int i = 0; i < count; i++) {
+        if(strcmp(keys[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+void bench_maps() {
+    // roughly the number of glyphs in the fonts we load
+    const int counts[2] = {100, 3000};
+    const int lookups = 200000;
+    for(int c = 0; c < 2; c++) {
+        int count = counts[c];
+        char** keys = malloc(count * sizeof(char*));
+        Map map;
+        map_init(&map, sizeof(int));
+        for(int i = 0; i < count; i++) {
+            keys[i] = malloc(17);
+            sprintf(keys[i], "glyph%i", i);
+            map_set(&map, keys[i], &i);
+        }
+        printf("maps (%i keys, %i lookups)\n", count, lookups);
+        BENCH("linear strcmp scan", {
+            int sum = 0;
+            for(int i = 0; i < lookups; i++) {
+                sum += linearKeyIndex(keys, count, keys[(i * 7919) % count]);
+            }
+            sink = sum;
+        })
+        BENCH("Map (open addressing)", {
+            int sum = 0;
+            for(int i = 0; i < lookups; i++) {
+                int v;
+                map_get(&map, keys[(i * 7919) % count], &v);
+                sum += v;
+            }
+            sink = sum;
+        })
+        // what callers keeping their keys interned get, no string pool lookup
+        char** interned = malloc(count * sizeof(char*));
+        for(int i = 0; i < count; i++) interned[i] = intern_string(keys[i]);
+        BENCH("Map (interned keys)", {
+            int sum = 0;
+            for(int i = 0; i < lookups; i++) {
+                int v;
+                map_get_interned(&map, interned[(i * 7919) % count], &v);
+                sum += v;
+            }
+            sink = sum;
+        })
+        free(interned);
+        FrozenMap frozen;
+        map_freeze(&map, &frozen);
+        BENCH("FrozenMap (perfect hash)", {
+            int sum = 0;
+            for(int i = 0; i < lookups; i++) {
+                int v;
+                frozen_map_get(&frozen, keys[(i * 7919) % count], &v);
+                sum += v;
+            }
+            sink = sum;
+        })
+        frozen_map_free(&frozen);
+        map_free(&map);
+        for(int i = 0; i < count; i++) free(keys[i]);
+        free(keys);
+    }
+}
+
+// what composing every element separately costs, without the SoA groups
+void composeOneByOne(struct TransformStore *store) {
+    for(int i = 0; i < store->size; i++) {
+        float t[3] = {store->tx[i], store->ty[i], store->tz[i]};
+        float s[3] = {store->sx[i], store->sy[i], store->sz[i]};
+        float r[3] = {store->rx[i], store->ry[i], store->rz[i]};
+        float o[3] = {store->ox[i], store->oy[i], store->oz[i]};
+        transform_compose(t, s, r, o, transform_store_model(store, i));
+    }
+}
+
+void bench_transforms() {
+    const int count = 10000;
+    printf("transforms (%i elements, every one dirty)\n", count);
+    struct TransformStore store;
+    transform_store_init(&store);
+    for(int i = 0; i < count; i++) {
+        transform_store_add(&store);
+        float t[3] = {i, 0, -2}, sc[3] = {1, 2, 1}, r[3] = {i * 0.01, 0.5, 0}, o[3] = {0.5, 0.5, 0};
+        transform_store_set(&store, i, t, sc, r, o);
+    }
+    BENCH("transform_compose one at a time", {
+        composeOneByOne(&store);
+        sink = store.models[count];
+    })
+    BENCH("transform_store_compose (SoA groups)", {
+        for(int i = 0; i < count; i++) transform_store_mark_dirty(&store, i);
+        transform_store_compose(&store);
+        sink = store.models[count];
+    })
+    transform_store_free(&store);
+}
+
+int main() {
+    bench_vectors();
+    bench_small_vectors();
+    bench_maps();
+    bench_transforms();
+    return 0;
+}
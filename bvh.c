@@ -0,0 +1,242 @@
+#include "bvh.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// deeper than any tree built by median splits of an int count of items
+#define BVH_STACK_SIZE 64
+
+void bvh_init(struct Bvh *bvh) {
+    memset(bvh, 0, sizeof(struct Bvh));
+    bvh->root = -1;
+}
+
+// internal, grow the per item arrays to hold item
+void reserveBvhItems(struct Bvh *bvh, int item) {
+    if(item < bvh->itemsAllocated) return;
+    int allocated = bvh->itemsAllocated > 0 ? bvh->itemsAllocated : 16;
+    while(allocated <= item) allocated *= 2;
+    bvh->boxes = realloc(bvh->boxes, allocated * sizeof(BvhBox));
+    bvh->leaves = realloc(bvh->leaves, allocated * sizeof(int));
+    bvh->present = realloc(bvh->present, allocated * sizeof(bool));
+    for(int i = bvh->itemsAllocated; i < allocated; i++) {
+        bvh->leaves[i] = -1;
+        bvh->present[i] = false;
+    }
+    bvh->itemsAllocated = allocated;
+}
+
+// internal, union of two boxes
+void unionBvhBoxes(const BvhBox *a, const BvhBox *b, BvhBox *out) {
+    for(int i = 0; i < 3; i++) {
+        out->min[i] = fminf(a->min[i], b->min[i]);
+        out->max[i] = fmaxf(a->max[i], b->max[i]);
+    }
+}
+
+void bvh_set(struct Bvh *bvh, int item, const BvhBox *box) {
+    reserveBvhItems(bvh, item);
+    if(item >= bvh->itemCount) bvh->itemCount = item + 1;
+    bvh->boxes[item] = *box;
+    if(!bvh->present[item]) {
+        bvh->present[item] = true;
+        bvh->needsRebuild = true;
+    }
+    int node = bvh->leaves[item];
+    if(node < 0) return;
+    bvh->nodes[node].box = *box;
+    // refit the ancestors, stopping as soon as one doesn't change
+    for(node = bvh->nodes[node].parent; node >= 0; node = bvh->nodes[node].parent) {
+        BvhNode *n = &bvh->nodes[node];
+        BvhBox fitted;
+        unionBvhBoxes(&bvh->nodes[n->left].box, &bvh->nodes[n->right].box, &fitted);
+        if(memcmp(&fitted, &n->box, sizeof(BvhBox)) == 0) break;
+        n->box = fitted;
+    }
+}
+
+void bvh_remove(struct Bvh *bvh, int item) {
+    if(item >= bvh->itemCount || !bvh->present[item]) return;
+    bvh->present[item] = false;
+    bvh->needsRebuild = true;
+}
+
+// internal, for qsort_r-less sorting of items on an axis
+struct Bvh *sortingBvh;
+int sortingAxis;
+
+float bvhBoxCenter(const BvhBox *box, int axis) {
+    return (box->min[axis] + box->max[axis]) * 0.5f;
+}
+
+int compareBvhItems(const void *a, const void *b) {
+    float ca = bvhBoxCenter(&sortingBvh->boxes[*(const int*)a], sortingAxis);
+    float cb = bvhBoxCenter(&sortingBvh->boxes[*(const int*)b], sortingAxis);
+    return (ca > cb) - (ca < cb);
+}
+
+// internal, builds the subtree of the count items, returns its node
+int buildBvhNode(struct Bvh *bvh, int *items, int count, int parent) {
+    int node = bvh->nodeCount++;
+    BvhNode *n = &bvh->nodes[node];
+    n->parent = parent;
+    if(count == 1) {
+        n->left = n->right = -1;
+        n->item = items[0];
+        n->box = bvh->boxes[items[0]];
+        bvh->leaves[items[0]] = node;
+        return node;
+    }
+    // split at the median of the axis along which the centers are the most spread
+    BvhBox centers = {{INFINITY, INFINITY, INFINITY}, {-INFINITY, -INFINITY, -INFINITY}};
+    for(int i = 0; i < count; i++) {
+        for(int a = 0; a < 3; a++) {
+            float c = bvhBoxCenter(&bvh->boxes[items[i]], a);
+            centers.min[a] = fminf(centers.min[a], c);
+            centers.max[a] = fmaxf(centers.max[a], c);
+        }
+    }
+    int axis = 0;
+    for(int a = 1; a < 3; a++) {
+        if(centers.max[a] - centers.min[a] > centers.max[axis] - centers.min[axis]) axis = a;
+    }
+    sortingBvh = bvh;
+    sortingAxis = axis;
+    qsort(items, count, sizeof(int), compareBvhItems);
+    int half = count / 2;
+    int left = buildBvhNode(bvh, items, half, node);
+    int right = buildBvhNode(bvh, items + half, count - half, node);
+    // nodes can't have moved, they are allocated up front
+    n->left = left;
+    n->right = right;
+    n->item = -1;
+    unionBvhBoxes(&bvh->nodes[left].box, &bvh->nodes[right].box, &n->box);
+    return node;
+}
+
+void bvh_build(struct Bvh *bvh) {
+    int *items = malloc((bvh->itemCount > 0 ? bvh->itemCount : 1) * sizeof(int));
+    int count = 0;
+    for(int i = 0; i < bvh->itemCount; i++) {
+        bvh->leaves[i] = -1;
+        if(bvh->present[i]) items[count++] = i;
+    }
+    bvh->nodeCount = 0;
+    bvh->root = -1;
+    bvh->needsRebuild = false;
+    if(count == 0) {
+        free(items);
+        return;
+    }
+    // a binary tree with count leaves has 2 * count - 1 nodes
+    if(bvh->nodesAllocated < 2 * count - 1) {
+        bvh->nodesAllocated = 2 * count - 1;
+        bvh->nodes = realloc(bvh->nodes, bvh->nodesAllocated * sizeof(BvhNode));
+    }
+    bvh->root = buildBvhNode(bvh, items, count, -1);
+    free(items);
+}
+
+// internal, -1 if the box is outside the plane, 1 if it is fully inside, 0 if it crosses it
+int classifyBvhBox(const BvhBox *box, const float plane[4]) {
+    // the corners the furthest along and against the plane normal
+    float far = plane[3], near = plane[3];
+    for(int a = 0; a < 3; a++) {
+        bool positive = plane[a] >= 0;
+        far += plane[a] * (positive ? box->max[a] : box->min[a]);
+        near += plane[a] * (positive ? box->min[a] : box->max[a]);
+    }
+    if(far < 0) return -1;
+    return near >= 0 ? 1 : 0;
+}
+
+// internal, append every item of the subtree of node to out
+int collectBvhItems(struct Bvh *bvh, int node, int *out, int count) {
+    int stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = node;
+    while(top > 0) {
+        BvhNode *n = &bvh->nodes[stack[--top]];
+        if(n->item >= 0) {
+            out[count++] = n->item;
+        } else {
+            stack[top++] = n->left;
+            stack[top++] = n->right;
+        }
+    }
+    return count;
+}
+
+int bvh_query_planes(struct Bvh *bvh, const float planes[6][4], int *out) {
+    if(bvh->needsRebuild) bvh_build(bvh);
+    if(bvh->root < 0) return 0;
+    int count = 0;
+    // nodes to visit, with the planes their parent wasn't already fully inside of (bit per plane)
+    int stack[BVH_STACK_SIZE];
+    int masks[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top] = bvh->root;
+    masks[top++] = 0x3f;
+    while(top > 0) {
+        top--;
+        int node = stack[top];
+        int mask = masks[top];
+        BvhNode *n = &bvh->nodes[node];
+        bool outside = false;
+        for(int p = 0; p < 6 && !outside; p++) {
+            if(!(mask & (1 << p))) continue;
+            int c = classifyBvhBox(&n->box, planes[p]);
+            if(c < 0) outside = true;
+            else if(c > 0) mask &= ~(1 << p);
+        }
+        if(outside) continue;
+        if(mask == 0) {
+            // fully inside every plane, no need to test anything below
+            count = collectBvhItems(bvh, node, out, count);
+        } else if(n->item >= 0) {
+            out[count++] = n->item;
+        } else {
+            stack[top] = n->left;
+            masks[top++] = mask;
+            stack[top] = n->right;
+            masks[top++] = mask;
+        }
+    }
+    return count;
+}
+
+void bvh_free(struct Bvh *bvh) {
+    free(bvh->nodes);
+    free(bvh->boxes);
+    free(bvh->leaves);
+    free(bvh->present);
+    bvh_init(bvh);
+}
+
+void bvh_box_transform(const BvhBox *box, const float m[16], BvhBox *out) {
+    // every axis of the result is the translation plus the extremes of each column's contribution
+    BvhBox result;
+    for(int i = 0; i < 3; i++) {
+        result.min[i] = result.max[i] = m[12 + i];
+        for(int j = 0; j < 3; j++) {
+            float a = m[j * 4 + i] * box->min[j];
+            float b = m[j * 4 + i] * box->max[j];
+            result.min[i] += fminf(a, b);
+            result.max[i] += fmaxf(a, b);
+        }
+    }
+    *out = result;
+}
+
+void frustum_planes_from_matrix(const float m[16], float planes[6][4]) {
+    for(int p = 0; p < 6; p++) {
+        // left / right from row 0, bottom / top from row 1, near / far from row 2, all added to / subtracted from row 3
+        int row = p / 2;
+        float sign = p % 2 == 0 ? 1 : -1;
+        for(int c = 0; c < 4; c++) planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+        float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if(length > 0) {
+            for(int c = 0; c < 4; c++) planes[p][c] /= length;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef _BVH_H
+#define _BVH_H
+#include <stdbool.h>
+
+typedef struct {
+    float min[3];
+    float max[3];
+} BvhBox;
+
+typedef struct {
+    BvhBox box;
+    // -1 for the root
+    int parent;
+    // children nodes, -1 for leaves
+    int left;
+    int right;
+    // item of a leaf, -1 for inner nodes
+    int item;
+} BvhNode;
+
+// bounding volume hierarchy over the boxes of items identified by small integers (indices of
+// something else). moving an item refits the boxes of its ancestors only, the tree is rebuilt
+// from scratch when items are added (or on demand)
+struct Bvh {
+    BvhNode* nodes;
+    int nodeCount;
+    int nodesAllocated;
+    int root;
+    // per item, indexed by the item id
+    BvhBox* boxes;
+    // leaf node of each item, -1 if it isn't in the tree (no box set, or added since the last build)
+    int* leaves;
+    // whether a box has been set for the item
+    bool* present;
+    int itemCount;
+    int itemsAllocated;
+    // set when an item was added, bvh_build needs to be called before querying
+    bool needsRebuild;
+};
+
+void bvh_init(struct Bvh *bvh);
+// set the box of an item, refitting its ancestors if it already is in the tree
+void bvh_set(struct Bvh *bvh, int item, const BvhBox *box);
+// take an item out of the next build (it stays in the tree until then)
+void bvh_remove(struct Bvh *bvh, int item);
+// build the tree over every present item, splitting on the median of the longest axis
+void bvh_build(struct Bvh *bvh);
+// write the id of every item whose box is at least partially inside the 6 planes (ax + by + cz + d >= 0
+// inside) to out (big enough for every item) and return how many there are. builds the tree if needed
+int bvh_query_planes(struct Bvh *bvh, const float planes[6][4], int *out);
+void bvh_free(struct Bvh *bvh);
+
+// world space box of a local box transformed by a column major 4x4 matrix (exact for any
+// rotation, the result encloses the 8 transformed corners)
+void bvh_box_transform(const BvhBox *box, const float matrix[16], BvhBox *out);
+// the 6 planes (left, right, bottom, top, near, far) of the frustum of a column major view projection matrix
+void frustum_planes_from_matrix(const float viewProjection[16], float planes[6][4]);
+#endif
@@ -1,37 +1,245 @@
 #include "events.h"
+#include <stdio.h>
+#include <string.h>
 
 void events_init(struct EventBroadcaster *ev) {
-    vector_init(&ev->subscribers, 5, sizeof(struct EventSubscriber));
+    vector_init(&ev->channels, 4, sizeof(struct EventChannel));
+    vector_init(&ev->subscriptions, 4, sizeof(struct EventSubscription));
+    map_init(&ev->eventIds, sizeof(int));
     ev->_eventIdSeed = 0;
+    ev->subscriberCount = 0;
+    ev->broadcasting = 0;
+    vector_int_init(&ev->dirtyChannels, 0);
+}
+
+int events_register(struct EventBroadcaster *ev, char* eventName) {
+    int* registered = map_get_pointer(&ev->eventIds, eventName);
+    if(registered != NULL) return *registered;
+    struct EventChannel channel;
+    channel.event_name = intern_string(eventName);
+    small_vector_init(&channel.subscribers, sizeof(struct EventSubscriber));
+    int eventId = ev->channels.size;
+    vector_push(&ev->channels, &channel);
+    map_set(&ev->eventIds, eventName, &eventId);
+    return eventId;
 }
 
 void events_subscribe(struct EventBroadcaster *ev, char* eventName, void (*eventCallback)(void* arg), int* id) {
+    events_subscribe_id(ev, events_register(ev, eventName), eventCallback, id);
+}
+
+void events_subscribe_id(struct EventBroadcaster *ev, int eventId, void (*eventCallback)(void* arg), int* id) {
+    struct EventChannel *channel = vector_get_pointer_to(ev->channels, eventId);
     struct EventSubscriber es;
-    es.event_name = eventName;
     es.event_callback = eventCallback;
     es.id = ev->_eventIdSeed++;
-    vector_push(&ev->subscribers, &es);
+    struct EventSubscription sub;
+    sub.event_id = eventId;
+    sub.index = channel->subscribers.size;
+    small_vector_push(&channel->subscribers, &es);
+    // subscriber ids are handed out in order, so es.id is the index of sub
+    vector_push(&ev->subscriptions, &sub);
+    ev->subscriberCount++;
     if(id != NULL)
         *id = es.id;
 }
 
 void events_unsubscribe(struct EventBroadcaster *ev, int id) {
-    for(int i = 0; i < ev->subscribers.size; i++) {
-        if(vector_get(ev->subscribers.data, i, struct EventSubscriber).id == id) {
-            vector_splice(&ev->subscribers, i, 1);
-        }
+    if(id < 0 || id >= ev->subscriptions.size) return;
+    struct EventSubscription *sub = vector_get_pointer_to(ev->subscriptions, id);
+    if(sub->index == -1) return;
+    struct EventChannel *channel = vector_get_pointer_to(ev->channels, sub->event_id);
+    struct EventSubscriber* subscribers = small_vector_data(&channel->subscribers);
+    ev->subscriberCount--;
+    if(ev->broadcasting > 0) {
+        // moving subscribers around would make the running broadcast call one twice or skip one,
+        // the slot is removed by removeClearedSubscribers once every broadcast returned
+        subscribers[sub->index].event_callback = NULL;
+        sub->index = -1;
+        vector_int_push(&ev->dirtyChannels, sub->event_id);
+        return;
     }
+    // swap remove: move the last subscriber into the hole and tell its subscription it moved
+    int last = channel->subscribers.size - 1;
+    if(sub->index != last) {
+        subscribers[sub->index] = subscribers[last];
+        vector_get(ev->subscriptions.data, subscribers[last].id, struct EventSubscription).index = sub->index;
+    }
+    channel->subscribers.size--;
+    sub->index = -1;
 }
 
 void events_broadcast(struct EventBroadcaster *ev, char* eventName, void* arg) {
-    for(int i = 0; i < ev->subscribers.size; i++) {
-        struct EventSubscriber es = vector_get(ev->subscribers.data, i, struct EventSubscriber);
-        if(es.event_name == eventName) {
-            (*es.event_callback)(arg);
+    // nobody can be subscribed to an event that was never registered
+    int* eventId = map_get_pointer(&ev->eventIds, eventName);
+    if(eventId == NULL) return;
+    events_broadcast_id(ev, *eventId, arg);
+}
+
+// internal, compacts the channels whose subscribers were unsubscribed during a broadcast
+void removeClearedSubscribers(struct EventBroadcaster *ev) {
+    for(int c = 0; c < ev->dirtyChannels.size; c++) {
+        struct EventChannel *channel = vector_get_pointer_to(ev->channels, ev->dirtyChannels.data[c]);
+        struct EventSubscriber* subscribers = small_vector_data(&channel->subscribers);
+        int kept = 0;
+        for(int i = 0; i < channel->subscribers.size; i++) {
+            if(subscribers[i].event_callback == NULL) continue;
+            subscribers[kept] = subscribers[i];
+            vector_get(ev->subscriptions.data, subscribers[kept].id, struct EventSubscription).index = kept;
+            kept++;
         }
+        channel->subscribers.size = kept;
     }
+    ev->dirtyChannels.size = 0;
+}
+
+void events_broadcast_id(struct EventBroadcaster *ev, int eventId, void* arg) {
+    struct EventChannel *channel = vector_get_pointer_to(ev->channels, eventId);
+    ev->broadcasting++;
+    // in subscription order. subscribers added by the callbacks are pushed after the ones being called and wait for
+    // the next broadcast, the data is fetched every time as pushing can move it (and registering an event can move the channel)
+    int count = channel->subscribers.size;
+    for(int i = 0; i < count; i++) {
+        channel = vector_get_pointer_to(ev->channels, eventId);
+        struct EventSubscriber es = vector_get(small_vector_data(&channel->subscribers), i, struct EventSubscriber);
+        if(es.event_callback != NULL) (*es.event_callback)(arg);
+    }
+    if(--ev->broadcasting == 0 && ev->dirtyChannels.size > 0) removeClearedSubscribers(ev);
 }
 
 void events_free(struct EventBroadcaster *ev) {
-    vector_free(ev->subscribers);
+    for(int i = 0; i < ev->channels.size; i++) {
+        struct EventChannel *channel = vector_get_pointer_to(ev->channels, i);
+        small_vector_free(&channel->subscribers);
+    }
+    vector_free(ev->channels);
+    vector_free(ev->subscriptions);
+    vector_int_free(ev->dirtyChannels);
+    map_free(&ev->eventIds);
+}
+
+// a drained event, moved out of the ring so that its cell can be reused right away
+struct DrainedEvent {
+    int event_id;
+    int payload_size;
+    union {
+        char bytes[EVENT_QUEUE_PAYLOAD_SIZE];
+        long double _align;
+        void* _alignp;
+    } payload;
+};
+
+void event_queue_init(struct EventQueue *q, struct EventBroadcaster *ev, int capacity) {
+    size_t c = vector_grow_capacity(1, capacity);
+    q->ev = ev;
+    q->cells = malloc(c * sizeof(struct QueuedEvent));
+    q->mask = c - 1;
+    // every cell starts with its own index as sequence, meaning "free for the producer at that position"
+    for(size_t i = 0; i < c; i++) {
+        atomic_init(&q->cells[i].sequence, i);
+    }
+    atomic_init(&q->enqueuePos, 0);
+    q->dequeuePos = 0;
+    vector_int_init(&q->coalesced, 4);
+    vector_int_init(&q->lastIndex, 4);
+    vector_init(&q->coalesceMerge, 4, sizeof(EventMerge));
+    vector_init(&q->batch, 16, sizeof(struct DrainedEvent));
+}
+
+bool event_queue_post(struct EventQueue *q, int eventId, void* payload, int payloadSize) {
+    if(payloadSize > EVENT_QUEUE_PAYLOAD_SIZE) {
+        printf("WARN: event payload too big to be queued (%i > %i)\n", payloadSize, EVENT_QUEUE_PAYLOAD_SIZE);
+        return false;
+    }
+    // Vyukov's bounded queue: claim a position with a CAS, the cell is ours once its sequence says so
+    size_t pos = atomic_load_explicit(&q->enqueuePos, memory_order_relaxed);
+    struct QueuedEvent *cell;
+    while(true) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        long diff = (long)seq - (long)pos;
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&q->enqueuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if(diff < 0) {
+            // the consumer hasn't freed that cell yet, the queue is full
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->enqueuePos, memory_order_relaxed);
+        }
+    }
+    cell->event_id = eventId;
+    cell->payload_size = payloadSize;
+    if(payloadSize > 0) memcpy(cell->payload.bytes, payload, payloadSize);
+    // publish
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+void event_queue_set_coalescing(struct EventQueue *q, int eventId, bool coalesce, EventMerge merge) {
+    if(eventId < 0) return;
+    while(q->coalesced.size <= eventId) {
+        EventMerge none = NULL;
+        vector_int_push(&q->coalesced, 0);
+        vector_int_push(&q->lastIndex, -1);
+        vector_push(&q->coalesceMerge, &none);
+    }
+    vector_int_set(&q->coalesced, coalesce, eventId);
+    vector_get(q->coalesceMerge.data, eventId, EventMerge) = merge;
+}
+
+int event_queue_dispatch(struct EventQueue *q) {
+    // drain everything posted before the call into the batch, events posted meanwhile (by
+    // other threads or the callbacks themselves) will wait for the next dispatch
+    size_t end = atomic_load_explicit(&q->enqueuePos, memory_order_acquire);
+    q->batch.size = 0;
+    while(q->dequeuePos != end) {
+        struct QueuedEvent *cell = &q->cells[q->dequeuePos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        // claimed but not published yet, it goes with the next dispatch
+        if(seq != q->dequeuePos + 1) break;
+        struct DrainedEvent de;
+        de.event_id = cell->event_id;
+        de.payload_size = cell->payload_size;
+        memcpy(de.payload.bytes, cell->payload.bytes, cell->payload_size);
+        vector_push(&q->batch, &de);
+        // hand the cell back to the producers, one lap later
+        atomic_store_explicit(&cell->sequence, q->dequeuePos + q->mask + 1, memory_order_release);
+        q->dequeuePos++;
+    }
+    struct DrainedEvent* batch = q->batch.data;
+    // find the last occurrence of every coalesced event, merging every occurrence into the next one
+    for(int i = 0; i < q->batch.size; i++) {
+        int id = batch[i].event_id;
+        if(id < q->coalesced.size && id >= 0 && q->coalesced.data[id]) q->lastIndex.data[id] = -1;
+    }
+    for(int i = 0; i < q->batch.size; i++) {
+        int id = batch[i].event_id;
+        if(id >= q->coalesced.size || id < 0 || !q->coalesced.data[id]) continue;
+        int previous = q->lastIndex.data[id];
+        EventMerge merge = vector_get(q->coalesceMerge.data, id, EventMerge);
+        if(previous != -1 && merge != NULL) (*merge)(batch[i].payload.bytes, batch[previous].payload.bytes);
+        q->lastIndex.data[id] = i;
+    }
+    int dispatched = 0;
+    for(int i = 0; i < q->batch.size; i++) {
+        int id = batch[i].event_id;
+        // only the consumer can read the channels, ids are checked here rather than by the producers
+        if(id < 0 || id >= q->ev->channels.size) {
+            printf("WARN: event_queue_dispatch, unknown event id %i\n", id);
+            continue;
+        }
+        if(id < q->coalesced.size && q->coalesced.data[id] && q->lastIndex.data[id] != i) continue;
+        events_broadcast_id(q->ev, id, batch[i].payload.bytes);
+        dispatched++;
+    }
+    return dispatched;
+}
+
+void event_queue_free(struct EventQueue *q) {
+    free(q->cells);
+    vector_int_free(q->coalesced);
+    vector_int_free(q->lastIndex);
+    vector_free(q->coalesceMerge);
+    vector_free(q->batch);
 }
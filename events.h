@@ -1,20 +1,105 @@
+#ifndef _EVENTS_H
+#define _EVENTS_H
 #ifndef Vector
 #include "vector.h"
 #endif
+#include "maps.h"
+#include <stdatomic.h>
 
 struct EventSubscriber {
-    char* event_name;
     void (*event_callback)(void* args);
     int id;
 };
 
+// a registered event and its subscribers
+struct EventChannel {
+    // interned
+    char* event_name;
+    SmallVector subscribers;
+};
+
+// where a subscription currently is, so that unsubscribing doesn't have to search for it
+struct EventSubscription {
+    int event_id;
+    // index in the channel's subscribers, -1 once unsubscribed
+    int index;
+};
+
 struct EventBroadcaster {
     int _eventIdSeed;
-    Vector subscribers;
+    // every registered event, indexed by event id
+    Vector channels;
+    // event name to event id
+    Map eventIds;
+    // indexed by subscriber id
+    Vector subscriptions;
+    // total number of subscribers across every event
+    int subscriberCount;
+    // how many events_broadcast_id calls are on the stack, subscribers unsubscribed meanwhile
+    // are only cleared (NULL callback) and removed from their channel once the last one returns
+    int broadcasting;
+    // ids of the channels with cleared subscribers
+    Vector_int dirtyChannels;
+};
+
+// folds the payload of a coalesced event that won't be dispatched into the one of the next event of the same id
+typedef void (*EventMerge)(void* latest, void* older);
+
+// biggest payload an event posted to an EventQueue can carry (it is copied in the queue)
+#define EVENT_QUEUE_PAYLOAD_SIZE 64
+
+struct QueuedEvent {
+    // bounded MPMC queue sequence number (see event_queue_post)
+    atomic_size_t sequence;
+    int event_id;
+    int payload_size;
+    union {
+        char bytes[EVENT_QUEUE_PAYLOAD_SIZE];
+        long double _align;
+        void* _alignp;
+    } payload;
+};
+
+// lock free multi producer / single consumer queue of events for an EventBroadcaster.
+// any thread can post, the thread owning the broadcaster (the main loop) drains the
+// queue and calls the subscribers in one batch with event_queue_dispatch.
+// NOTE: events must be registered (events_register) on the consumer thread before being posted
+struct EventQueue {
+    struct EventBroadcaster *ev;
+    struct QueuedEvent* cells;
+    size_t mask;
+    atomic_size_t enqueuePos;
+    // only touched by the consumer
+    size_t dequeuePos;
+    // indexed by event id, whether only the last event of a batch is dispatched
+    Vector_int coalesced;
+    // indexed by event id, how a coalesced event is folded into the next one (can be NULL)
+    Vector coalesceMerge;
+    // consumer side buffers, kept between dispatches to avoid reallocating every frame
+    Vector batch;
+    Vector_int lastIndex;
 };
 
 void events_init(struct EventBroadcaster *ev);
+// returns the id of eventName, registering it if it isn't already. ids can be used
+// with the *_id functions to skip the name lookup
+int events_register(struct EventBroadcaster *ev, char* eventName);
 void events_subscribe(struct EventBroadcaster *ev, char* eventName, void (*eventCallback)(void* arg), int* id);
+void events_subscribe_id(struct EventBroadcaster *ev, int eventId, void (*eventCallback)(void* arg), int* id);
 void events_unsubscribe(struct EventBroadcaster *ev, int id);
 void events_broadcast(struct EventBroadcaster *ev, char* eventName, void* arg);
+void events_broadcast_id(struct EventBroadcaster *ev, int eventId, void* arg);
 void events_free(struct EventBroadcaster *ev);
+// capacity is rounded up to a power of two
+void event_queue_init(struct EventQueue *q, struct EventBroadcaster *ev, int capacity);
+// thread safe, copies payloadSize bytes of payload (can be NULL if payloadSize is 0),
+// returns false if the queue is full or the payload too big. events of an unknown id are dropped when dispatched
+bool event_queue_post(struct EventQueue *q, int eventId, void* payload, int payloadSize);
+// when coalescing, only the most recent event of eventId posted since the last dispatch is dispatched.
+// merge (can be NULL) is called on the consumer thread with the payloads of every dropped event and the
+// one following it, to carry over what the latest one must not lose (the oldest timestamp for example)
+void event_queue_set_coalescing(struct EventQueue *q, int eventId, bool coalesce, EventMerge merge);
+// consumer thread only, dispatches every event posted before the call, returns how many were dispatched
+int event_queue_dispatch(struct EventQueue *q);
+void event_queue_free(struct EventQueue *q);
+#endif
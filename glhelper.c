@@ -2,8 +2,10 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -16,19 +18,52 @@
 static const char* attributes[] = {
     "vPos",
     "vNormal",
-    "vTexCoord"
+    "vTexCoord",
+    // per instance model matrix of instanced programs, a mat4 takes 4 locations (3 to 6)
+    "iModel"
 };
+// location of iModel in the attributes above
+#define GLH_INSTANCE_ATTRIBUTE 3
+// most shaders a program can be made of (vertex, tessellation control and evaluation, geometry, fragment)
+#define GLH_PROGRAM_MAX_STAGES 5
 // set the margin that will be applied to every character in the atlas of a font to avoid
 // having a character rendering a thin line of pixels of its neighbour because of float precision.
 // (to understand better, just look at the generated atlas texture with this value set to 2 and 10)
 static const int CharMarginSize = 2;
 
-static char fontGlyphDataMapDefaultKey[9] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, '\0'};
-
 GlhGlobalShaders GlobalShaders;
 
 bool globalShadersReady;
 
+// see GlhSetProgramCacheDirectory
+char* ProgramCacheDirectory = GLH_PROGRAM_CACHE_DIRECTORY;
+// programs built during this run, by the hex of their key, so every variant is only built once
+Map ProgramVariants;
+// start of every program key, the hash of the driver (binaries are only valid for the one that made them)
+unsigned long long ProgramKeySeed;
+// whether the driver can give program binaries back at all
+bool programBinariesSupported;
+// whether the driver compiles on threads of its own and can tell when it is done (GL_KHR_parallel_shader_compile)
+bool parallelCompileSupported;
+bool programCacheReady = false;
+
+// internal, a program compiled from source whose compilation and linking may still be running on the driver's
+// threads. nothing about it is queried until something needs it, which is what would make the driver wait
+typedef struct {
+    GLuint program;
+    unsigned long long key;
+    GLuint shaders[GLH_PROGRAM_MAX_STAGES];
+    // interned, for the logs
+    char* filenames[GLH_PROGRAM_MAX_STAGES];
+    int shaderCount;
+    // whether the binary goes to the program cache once linked
+    bool cache;
+} PendingProgram;
+
+VECTOR_DECLARE(PendingProgram)
+
+Vector_PendingProgram PendingPrograms;
+
 FT_Library ft;
 
 unsigned int OpenGLObjectLabelID = 0;
@@ -64,8 +99,158 @@ void set_opengl_label(GLenum identifier, GLuint name, char* label) {
     glObjectLabel(identifier, name, labelLength, newLabel);
 }
 
+GlhGLState GLState;
+
+// saved states of GlhPushState
+struct Stack GLStateStack;
+
+bool GLStateStackReady = false;
+
+bool GlhUseProgram(GLuint program) {
+    if(GLState.program == program) return false;
+    glUseProgram(GLState.program = program);
+    return true;
+}
+
+bool GlhBindVertexArray(GLuint VAO) {
+    if(GLState.VAO == VAO) return false;
+    glBindVertexArray(GLState.VAO = VAO);
+    return true;
+}
+
+bool GlhBindFramebuffer(GLuint framebuffer) {
+    if(GLState.framebuffer == framebuffer) return false;
+    glBindFramebuffer(GL_FRAMEBUFFER, GLState.framebuffer = framebuffer);
+    return true;
+}
+
+bool GlhActiveTexture(int unit) {
+    if(GLState.activeTextureUnit == unit) return false;
+    glActiveTexture(GL_TEXTURE0 + (GLState.activeTextureUnit = unit));
+    return true;
+}
+
+bool GlhBindTexture(GLuint texture) {
+    int unit = GLState.activeTextureUnit;
+    // units past the mirrored ones (or an unknown unit) are never filtered
+    if(unit >= 0 && unit < GLH_STATE_TEXTURE_UNITS) {
+        if(GLState.textures[unit] == texture) return false;
+        GLState.textures[unit] = texture;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    return true;
+}
+
+void GlhDeleteTexture(GLuint texture) {
+    // GL unbinds a deleted texture from every unit, names get reused so the mirror has to forget it too
+    for(int i = 0; i < GLH_STATE_TEXTURE_UNITS; i++) {
+        if(GLState.textures[i] == texture) GLState.textures[i] = 0;
+    }
+    glDeleteTextures(1, &texture);
+}
+
+void GlhDeleteFramebuffer(GLuint framebuffer) {
+    // deleting the bound framebuffer binds the default one
+    if(GLState.framebuffer == framebuffer) GLState.framebuffer = 0;
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+bool GlhClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    GLfloat *c = GLState.clearColor;
+    if(c[0] == r && c[1] == g && c[2] == b && c[3] == a) return false;
+    c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+    glClearColor(r, g, b, a);
+    return true;
+}
+
+bool GlhSetBlend(bool enabled) {
+    if(GLState.blend == enabled) return false;
+    if((GLState.blend = enabled)) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+    return true;
+}
+
+bool GlhBlendFunc(GLenum src, GLenum dst) {
+    if(GLState.blendSrc == src && GLState.blendDst == dst) return false;
+    glBlendFunc(GLState.blendSrc = src, GLState.blendDst = dst);
+    return true;
+}
+
+bool GlhSetDepthTest(bool enabled) {
+    if(GLState.depthTest == enabled) return false;
+    if((GLState.depthTest = enabled)) glEnable(GL_DEPTH_TEST);
+    else glDisable(GL_DEPTH_TEST);
+    return true;
+}
+
+bool GlhDepthFunc(GLenum func) {
+    if(GLState.depthFunc == func) return false;
+    glDepthFunc(GLState.depthFunc = func);
+    return true;
+}
+
+const GlhGLState* GlhGetState() {
+    return &GLState;
+}
+
+void GlhPushState() {
+    if(!GLStateStackReady) {
+        stack_init(&GLStateStack, sizeof(GlhGLState));
+        GLStateStackReady = true;
+    }
+    stack_push(&GLStateStack, &GLState);
+}
+
+void GlhPopState() {
+    if(!GLStateStackReady || stack_is_empty(GLStateStack)) {
+        printf("WARN: popping GL state without a matching push\n");
+        return;
+    }
+    GlhGLState saved;
+    stack_pop(&GLStateStack, &saved);
+    // go through the filtered setters, so only what changed since the push is sent
+    // values that were unknown at push time are left as they are
+    if(saved.program != GLH_UNKNOWN_BINDING) GlhUseProgram(saved.program);
+    if(saved.VAO != GLH_UNKNOWN_BINDING) GlhBindVertexArray(saved.VAO);
+    if(saved.framebuffer != GLH_UNKNOWN_BINDING) GlhBindFramebuffer(saved.framebuffer);
+    for(int i = 0; i < GLH_STATE_TEXTURE_UNITS; i++) {
+        if(GLState.textures[i] == saved.textures[i] || saved.textures[i] == GLH_UNKNOWN_BINDING) continue;
+        GlhActiveTexture(i);
+        GlhBindTexture(saved.textures[i]);
+    }
+    if(saved.activeTextureUnit != -1) GlhActiveTexture(saved.activeTextureUnit);
+    if(!isnan(saved.clearColor[0])) GlhClearColor(saved.clearColor[0], saved.clearColor[1], saved.clearColor[2], saved.clearColor[3]);
+    if(saved.blend != -1) GlhSetBlend(saved.blend);
+    if(saved.blendSrc != 0) GlhBlendFunc(saved.blendSrc, saved.blendDst);
+    if(saved.depthTest != -1) GlhSetDepthTest(saved.depthTest);
+    if(saved.depthFunc != 0) GlhDepthFunc(saved.depthFunc);
+}
+
+void GlhResetStateCache() {
+    GlhGLState defaults = {};
+    defaults.blendSrc = GL_ONE;
+    defaults.blendDst = GL_ZERO;
+    defaults.depthFunc = GL_LESS;
+    GLState = defaults;
+}
+
+void GlhInvalidateStateCache() {
+    GLState.program = GLState.VAO = GLState.framebuffer = GLH_UNKNOWN_BINDING;
+    GLState.activeTextureUnit = -1;
+    for(int i = 0; i < GLH_STATE_TEXTURE_UNITS; i++) GLState.textures[i] = GLH_UNKNOWN_BINDING;
+    // NaN never compares equal, so the next clear color is always sent
+    GLState.clearColor[0] = NAN;
+    GLState.blend = GLState.depthTest = -1;
+    // 0 isn't a valid value for any of those
+    GLState.blendSrc = GLState.blendDst = GLState.depthFunc = 0;
+}
+
 int readFile(char* filename, int* size,char **content) {
 	FILE* file = fopen(filename, "rb");
+    if(file == NULL) {
+        printf("ERROR: readFile, unable to open %s\n", filename);
+        return -1;
+    }
     // get file size
 	fseek(file, 0, SEEK_END);
 	long f_size = ftell(file);
@@ -85,52 +270,182 @@ int readFile(char* filename, int* size,char **content) {
 	return 0;
 }
 
-int loadShader(char* filename, int type, GLuint *shader) {    
-    char* source;
-    int size;
-    // read source file and store content in source
-    if(readFile(filename, &size, &source) != 0) {
-        return -1;
-    }; 
-    // because glShaderSource only accepts const char*
-    const char* shader_source = source;
-    // create, source and compile shader
-    *shader = glCreateShader(type);
-    set_opengl_label(GL_SHADER, *shader, "SHADER");
-    glShaderSource(*shader, 1, &shader_source, NULL);
-    glCompileShader(*shader);
-    // free precedentaly allocated memory for source
-    free(source);
-    return 0;
+void GlhSetProgramCacheDirectory(char* directory) {
+    ProgramCacheDirectory = directory;
+}
+
+// internal, needs a current context, the driver strings are part of the keys
+void initProgramCache() {
+    if(programCacheReady) return;
+    map_init(&ProgramVariants, sizeof(GLuint));
+    vector_PendingProgram_init(&PendingPrograms, 8);
+    // compile and link on as many threads as the driver wants, off the main thread
+    if(GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xffffffff);
+    } else if(GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xffffffff);
+    }
+    parallelCompileSupported = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    GLint formats = 0;
+    if(GLEW_ARB_get_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    programBinariesSupported = formats > 0;
+    ProgramKeySeed = SHADER_CACHE_HASH_SEED;
+    GLenum driverStrings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for(int i = 0; i < 3; i++) {
+        const char* string = (const char*) glGetString(driverStrings[i]);
+        ProgramKeySeed = shader_cache_hash_string(ProgramKeySeed, string != NULL ? string : "");
+    }
+    programCacheReady = true;
+}
+
+// internal, give program the cached binary of key. false if there is none, or if the driver refused it
+bool loadCachedProgram(GLuint program, unsigned long long key) {
+    unsigned int format;
+    void* binary;
+    int length;
+    if(shader_cache_load(ProgramCacheDirectory, key, &format, &binary, &length) != 0) return false;
+    glProgramBinary(program, format, binary, length);
+    free(binary);
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+// internal, write the binary of a linked program to the cache
+void storeCachedProgram(GLuint program, unsigned long long key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+    void* binary = malloc(length);
+    GLenum format;
+    glGetProgramBinary(program, length, NULL, &format, binary);
+    shader_cache_store(ProgramCacheDirectory, key, format, binary, length);
+    free(binary);
+}
+
+// internal, start compiling the count sources (of the types in types, read from filenames) with the defines added
+// and linking them into program, without waiting for any of it (see finishCompiledProgram)
+void submitProgram(GLuint program, GLenum types[], char* sources[], char* filenames[], int count, char* defines[], int definesCount, unsigned long long key, bool cache) {
+    PendingProgram pending = {program, key};
+    pending.shaderCount = count;
+    pending.cache = cache;
+    for(int i = 0; i < count; i++) {
+        char* source = definesCount > 0 ? shader_source_with_defines(sources[i], defines, definesCount) : sources[i];
+        // because glShaderSource only accepts const char*
+        const char* shader_source = source;
+        pending.shaders[i] = glCreateShader(types[i]);
+        pending.filenames[i] = intern_string(filenames[i]);
+        set_opengl_label(GL_SHADER, pending.shaders[i], "SHADER");
+        glShaderSource(pending.shaders[i], 1, &shader_source, NULL);
+        glCompileShader(pending.shaders[i]);
+        if(source != sources[i]) free(source);
+        glAttachShader(program, pending.shaders[i]);
+    }
+    // lets the driver keep what glGetProgramBinary needs
+    if(cache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    vector_PendingProgram_push(&PendingPrograms, pending);
 }
 
-int initProgram(char* fragSourceFilename, char* vertSourceFilename, GLuint *program) {
-    // declare shaders
-    GLuint vert;
-    GLuint frag;
-    // load them
-    loadShader(vertSourceFilename, GL_VERTEX_SHADER, &vert);
-    loadShader(fragSourceFilename, GL_FRAGMENT_SHADER, &frag);
-    // attaches the shaders to the program
-    glAttachShader(*program, vert);
-    glAttachShader(*program, frag);
+// internal, index of program in PendingPrograms, -1 if it isn't (loaded from the cache, or already finished)
+int pendingProgramIndex(GLuint program) {
+    if(!programCacheReady) return -1;
+    for(int i = 0; i < PendingPrograms.size; i++) {
+        if(PendingPrograms.data[i].program == program) return i;
+    }
+    return -1;
+}
 
-    glLinkProgram(*program);
+// internal, whether the driver is still compiling or linking program. false if it can't tell
+bool programCompiling(GLuint program) {
+    if(!parallelCompileSupported || pendingProgramIndex(program) < 0) return false;
+    GLint done;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != GL_TRUE;
+}
+
+// internal, wait for a program given to submitProgram to be linked (if it still isn't), print the logs of what
+// failed and cache it. nothing to do for other programs. returns 0 if it linked, -1 otherwise
+int finishCompiledProgram(GLuint program) {
+    int index = pendingProgramIndex(program);
+    if(index < 0) return 0;
+    PendingProgram pending = PendingPrograms.data[index];
+    vector_PendingProgram_splice(&PendingPrograms, index, 1);
+    char log[1024];
+    // the first status query is where the main thread waits for the driver if it isn't done
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE) {
+        for(int i = 0; i < pending.shaderCount; i++) {
+            GLint compiled;
+            glGetShaderiv(pending.shaders[i], GL_COMPILE_STATUS, &compiled);
+            if(compiled == GL_TRUE) continue;
+            glGetShaderInfoLog(pending.shaders[i], sizeof(log), NULL, log);
+            printf("ERROR: finishCompiledProgram, unable to compile %s\n%s\n", pending.filenames[i], log);
+        }
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        printf("ERROR: finishCompiledProgram, unable to link %s\n%s\n", pending.filenames[0], log);
+    }
+    // the linked program doesn't need them anymore
+    for(int i = 0; i < pending.shaderCount; i++) {
+        glDetachShader(program, pending.shaders[i]);
+        glDeleteShader(pending.shaders[i]);
+    }
+    if(linked != GL_TRUE) return -1;
+    if(pending.cache) storeCachedProgram(program, pending.key);
     return 0;
 }
 
-void GlhTransformsToMat4(GlhTransforms *tsf, mat4 *mat) {
-    glm_mat4_identity(*mat);
-    vec3 reverseTransformOrigin;
-    glm_vec3_negate_to(tsf->transformsOrigin, reverseTransformOrigin);
+// internal, program made of the count shader files (of the types in types) with the defines added to each of them,
+// its attributes bound to the indexes of the attributes array. the key hashing all of that (and the driver) is
+// looked up in the programs already built during this run first, then in the program cache, and the program
+// is only submitted for compilation (and cached once finished) if neither has it. returns 0 if a file couldn't be read
+GLuint buildProgram(GLenum types[], char* filenames[], int count, char* defines[], int definesCount) {
+    initProgramCache();
+    if(count > GLH_PROGRAM_MAX_STAGES) {
+        printf("ERROR: buildProgram, %i shaders for a single program\n", count);
+        return 0;
+    }
+    int attributesCount = sizeof(attributes) / sizeof(attributes[0]);
+    unsigned long long key = ProgramKeySeed;
+    for(int i = 0; i < attributesCount; i++) key = shader_cache_hash_string(key, attributes[i]);
+    key = shader_cache_hash(key, &definesCount, sizeof(definesCount));
+    for(int i = 0; i < definesCount; i++) key = shader_cache_hash_string(key, defines[i]);
+    char* sources[count];
+    for(int i = 0; i < count; i++) {
+        int size;
+        if(readFile(filenames[i], &size, &sources[i]) != 0) {
+            for(int j = 0; j < i; j++) free(sources[j]);
+            return 0;
+        }
+        key = shader_cache_hash(key, &types[i], sizeof(types[i]));
+        key = shader_cache_hash_string(key, sources[i]);
+    }
+    char name[17];
+    sprintf(name, "%016llx", key);
+    GLuint program = 0;
+    if(map_has(&ProgramVariants, name)) {
+        map_get(&ProgramVariants, name, &program);
+    } else {
+        program = glCreateProgram();
+        set_opengl_label(GL_PROGRAM, program, "SHADER_PROGRAM");
+        // set attribute location to the indexes of the attributes array
+        for(int i = 0; i < attributesCount; i++) {
+            glBindAttribLocation(program, i, attributes[i]);
+        }
+        bool cached = ProgramCacheDirectory != NULL && programBinariesSupported;
+        if(!(cached && loadCachedProgram(program, key))) {
+            submitProgram(program, types, sources, filenames, count, defines, definesCount, key, cached);
+        }
+        map_set(&ProgramVariants, name, &program);
+    }
+    for(int i = 0; i < count; i++) free(sources[i]);
+    return program;
+}
 
-    glm_translate(*mat, tsf->translation);
-    glm_scale(*mat, tsf->scale);
-    glm_translate(*mat, tsf->transformsOrigin);
-    glm_rotate_x(*mat, tsf->rotation[0], *mat);
-    glm_rotate_y(*mat, tsf->rotation[1], *mat);
-    glm_rotate_z(*mat, tsf->rotation[2], *mat);
-    glm_translate(*mat, reverseTransformOrigin);
+void GlhTransformsToMat4(GlhTransforms *tsf, mat4 *mat) {
+    // closed form of translate * scale * translate(origin) * rotate x, y, z * translate(-origin)
+    transform_compose(tsf->translation, tsf->scale, tsf->rotation, tsf->transformsOrigin, (float*) *mat);
 }
 
 GlhTransforms GlhGetIdentityTransform() {
@@ -142,113 +457,152 @@ GlhTransforms GlhGetIdentityTransform() {
 }
 
 void GlhInitProgram(GlhProgram *prg, char* fragSourceFilename, char* vertSourceFilename, char* uniforms[], int uniformsCount, void (*setUniforms)()) {
-    int attributesCount = sizeof(attributes) / sizeof(attributes[0]);
-    // init shader program
-    prg->shaderProgram = glCreateProgram();
+    GlhInitProgramVariant(prg, fragSourceFilename, vertSourceFilename, NULL, 0, uniforms, uniformsCount, setUniforms);
+}
 
-    // set attribute location to the indexes of the attributes array
-    for(int i = 0; i < attributesCount; i++) {
-        glBindAttribLocation(prg->shaderProgram, i, attributes[i]);
+void GlhInitProgramVariant(GlhProgram *prg, char* fragSourceFilename, char* vertSourceFilename, char* defines[], int definesCount, char* uniforms[], int uniformsCount, void (*setUniforms)()) {
+    int attributesCount = sizeof(attributes) / sizeof(attributes[0]);
+    // from the variants built during this run, the program cache, or submitted for compilation
+    GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    char* filenames[] = {vertSourceFilename, fragSourceFilename};
+    prg->shaderProgram = buildProgram(types, filenames, 2, defines, definesCount);
+    if(prg->shaderProgram == 0) {
+        printf("ERROR: GlhInitProgramVariant, unable to build the program of %s and %s\n", vertSourceFilename, fragSourceFilename);
     }
-    // read, load compile attach and link shaders to program
-    initProgram(fragSourceFilename, vertSourceFilename, &prg->shaderProgram);
+    // everything about the linked program is queried by GlhFinishProgram, once something needs it
+    prg->pending = true;
+    prg->instanced = false;
     // initialze vectors
-    vector_init(&prg->uniforms, uniformsCount, sizeof(char*));
-    vector_init(&prg->uniformsLocation, uniformsCount, sizeof(GLint));
-    vector_init(&prg->attributes, attributesCount, sizeof(char*));
+    small_vector_init(&prg->uniforms, sizeof(char*));
+    vector_GLint_init(&prg->uniformsLocation, uniformsCount);
+    small_vector_init(&prg->attributes, sizeof(char*));
     // push the fixed size arrays' values into the vectors
-    vector_push_array(&prg->uniforms, uniforms, uniformsCount);
+    small_vector_push_array(&prg->uniforms, uniforms, uniformsCount);
     //* NOTE: the attribute vector is not really needed, as it will always be the 
     //* same as the attributes global array but i choosed to keep it that way if
     //* i ever come arround to implement custom attributes for whatever reasons
-    vector_push_array(&prg->attributes, attributes, attributesCount);
-    // get the uniforms' location
-    for(int i = 0; i < uniformsCount; i++) {
-        GLint v = glGetUniformLocation(prg->shaderProgram, vector_get(prg->uniforms.data, i, char*));
-        vector_push(&prg->uniformsLocation, &v);
-    }
-    set_opengl_label(GL_PROGRAM, prg->shaderProgram, "SHADER_PROGRAM");
+    small_vector_push_array(&prg->attributes, attributes, attributesCount);
     // set the setGlobalUniforms function pointer
     prg->setGlobalUniforms = setUniforms;
 }
 
+void GlhFinishProgram(GlhProgram *prg) {
+    if(!prg->pending) return;
+    prg->pending = false;
+    // a program that couldn't be built or failed to link has nothing to ask GL (every query would be an
+    // invalid operation), its uniforms are all missing (-1)
+    bool built = prg->shaderProgram != 0 && finishCompiledProgram(prg->shaderProgram) == 0;
+    if(built) {
+        prg->instanced = glGetAttribLocation(prg->shaderProgram, "iModel") != -1;
+        // the camera matrices are shared by every program through the same uniform buffer
+        GLuint cameraBlock = glGetUniformBlockIndex(prg->shaderProgram, "GlhCamera");
+        if(cameraBlock != GL_INVALID_INDEX) {
+            glUniformBlockBinding(prg->shaderProgram, cameraBlock, GLH_CAMERA_BLOCK_BINDING);
+        }
+    }
+    // get the uniforms' location
+    Map uniformsByName;
+    map_init(&uniformsByName, sizeof(GLint));
+    for(int i = 0; i < prg->uniforms.size; i++) {
+        char* name = vector_get(small_vector_data(&prg->uniforms), i, char*);
+        GLint v = built ? glGetUniformLocation(prg->shaderProgram, name) : -1;
+        vector_GLint_push(&prg->uniformsLocation, v);
+        map_set(&uniformsByName, name, &v);
+    }
+    map_freeze(&uniformsByName, &prg->uniformsByName);
+    map_free(&uniformsByName);
+}
+
+bool GlhPollProgram(GlhProgram *prg) {
+    if(!prg->pending) return true;
+    if(programCompiling(prg->shaderProgram)) return false;
+    GlhFinishProgram(prg);
+    return true;
+}
+
+bool GlhPollPrograms(GlhProgram *programs[], int count) {
+    bool ready = true;
+    // polled one by one, the ones that are done are finished even if others aren't
+    for(int i = 0; i < count; i++) ready &= GlhPollProgram(programs[i]);
+    return ready;
+}
+
+// the view projection comes from the camera block, only the model matrix is per object
 void __GS_glyphs_uniform(GlhTextObject *obj, GlhContext *ctx) {
-    mat4 mvp, mv;
-    glm_mat4_mul(ctx->cachedViewMatrix, obj->cachedModelMatrix, mv);
-    glm_mat4_mul(ctx->cachedProjectionMatrix, mv, mvp);
-    glUniformMatrix4fv(vector_get(obj->glyphProgram->uniformsLocation.data, 0, GLint), 1, GL_FALSE,(float*) mvp);
+    glUniformMatrix4fv(vector_GLint_get(&obj->glyphProgram->uniformsLocation, 0), 1, GL_FALSE,(float*) obj->cachedModelMatrix);
 }
 
 void __GS_text_uniform(GlhTextObject *obj, GlhContext *ctx) {
-    mat4 mvp, mv;
-    glm_mat4_mul(ctx->cachedViewMatrix, obj->cachedModelMatrix, mv);
-    glm_mat4_mul(ctx->cachedProjectionMatrix, mv, mvp);
-    glUniformMatrix4fv(vector_get(obj->glyphProgram->uniformsLocation.data, 0, GLint), 1, GL_FALSE,(float*) mvp);
+    glUniformMatrix4fv(vector_GLint_get(&obj->textProgram->uniformsLocation, 0), 1, GL_FALSE,(float*) obj->cachedModelMatrix);
 }
 
 void _makeGlobalShaderReady() {
     if(globalShadersReady) return;
+    globalShadersReady = true;
 
     char* glyphs_uniforms[] = {
-        "MVP",
+        "model",
         "uTexture"
     };
     char* text_uniforms[] = {
-        "MVP",
+        "model",
         "uTexture"
     };
 
     GlhInitProgram(&GlobalShaders.glyphs, "shaders/glyphs.frag", "shaders/glyphs.vert", glyphs_uniforms, 2, __GS_glyphs_uniform);
     GlhInitProgram(&GlobalShaders.text, "shaders/text.frag", "shaders/text.vert", text_uniforms, 2, __GS_text_uniform);
+    // already in world space, the camera block is all it needs
+    char* batched_text_uniforms[] = {
+        "uTexture"
+    };
+    GlhInitProgram(&GlobalShaders.batchedText, "shaders/text_batched.frag", "shaders/text_batched.vert", batched_text_uniforms, 1, NULL);
+}
+
+// internal, the pool of a key, NULL if there is none
+GlhFBOPool* findFBOPool(GlhFBOProvider *provider, GlhFBOType type, int width, int height, GLenum format) {
+    for(int i = 0; i < provider->pools.size; i++) {
+        GlhFBOPool *pool = vector_get_pointer_to(provider->pools, i);
+        if(pool->type == type && pool->width == width && pool->height == height && pool->format == format) return pool;
+    }
+    return NULL;
 }
 
 void GlhDeleteFBO(GlhFBOProvider *provider, GlhFBO fbo) {
     // getting a pointer because fbo could be a copy and outdated
     GlhFBO *pfbo = vector_get_pointer_to(provider->FBOs, fbo.id);
 
+    if(!pfbo->alive) return;
     if(pfbo->active) {
         printf("WARN: deleting active FBO\n");
+    } else {
+        // a released FBO waits in its pool, it must not be handed out once deleted
+        GlhFBOPool *pool = findFBOPool(provider, pfbo->type, pfbo->width, pfbo->height, pfbo->format);
+        for(int i = 0; pool != NULL && i < pool->freeIds.size; i++) {
+            if(pool->freeIds.data[i] != fbo.id) continue;
+            pool->freeIds.data[i] = pool->freeIds.data[--pool->freeIds.size];
+            break;
+        }
     }
 
     switch (fbo.type) {
         case FBSizedTexture:
         {
-            glDeleteTextures(1, &fbo.attachments[0]);
+            GlhDeleteTexture(fbo.attachments[0]);
             glDeleteRenderbuffers(1, &fbo.attachments[1]);
-            glDeleteFramebuffers(1, &fbo.FBO);
+            GlhDeleteFramebuffer(fbo.FBO);
         }
         break;
     }
 
-    vector_splice(&provider->FBOs, fbo.id, 1, NULL);
+    // the slot stays where it is so every other id remains valid
+    pfbo->alive = false;
+    pfbo->active = false;
+    vector_int_push(&provider->freeSlots, fbo.id);
 }
 
 bool GlhVerrifieFBO(GlhFBOProvider *provider, GlhFBO fbo) {
-    bool valid = true;
-
-    switch (fbo.type) {
-        case FBSizedTexture:
-        {   
-            int width, height;
-            glfwGetFramebufferSize(provider->ctx->window, &width, &height);
-
-            int w, h;
-            int miplevel = 0;
-            glBindTexture(GL_TEXTURE_2D, fbo.attachments[0]);
-            glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_WIDTH, &w);
-            glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_HEIGHT, &h);
-
-            if(w != width || h != height){
-                valid = false;
-            }
-        }
-        break;
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo.FBO);
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        valid = false;
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // size changes are handled by the generation, nothing to check against GL
+    bool valid = fbo.alive && fbo.generation == provider->generation;
 
     if(fbo.active && !valid) {
         printf("WARN: found invalid active FBO\n");
@@ -257,65 +611,73 @@ bool GlhVerrifieFBO(GlhFBOProvider *provider, GlhFBO fbo) {
     return valid;
 }
 
-GlhFBO GlhRequestFBO(GlhFBOProvider *provider, GlhFBOType type) {
-    int found = -1;
-    for(int i = 0; i < provider->FBOs.size; i++) {
-        GlhFBO fbo = vector_get(provider->FBOs.data, i, GlhFBO);
-        bool valid = GlhVerrifieFBO(provider, fbo);
-
-        if(!valid) {
-            GlhDeleteFBO(provider, fbo);
-            // to stay at the same index next iteration
-            i--;
-            continue;
-        }
-
-        if(!fbo.active && fbo.type == type) {
-            found = i;
+// internal, size and format FBOs of type are created with
+void FBOTypeSpecifics(GlhFBOProvider *provider, GlhFBOType type, int *width, int *height, GLenum *format) {
+    switch (type) {
+        case FBSizedTexture:
+            *width = provider->width;
+            *height = provider->height;
+            *format = GL_RGBA8;
             break;
-        }
     }
-    if(found != -1) {
-        GlhFBO *fbo = vector_get_pointer_to(provider->FBOs, found);        
-
-        fbo->active = true;
-
-        switch (fbo->type) {
-            case FBSizedTexture:
-            {
-                glBindFramebuffer(GL_FRAMEBUFFER, fbo->FBO);
-                GLfloat oldClearColor[4];
-                glGetFloatv(GL_COLOR_CLEAR_VALUE, oldClearColor);
-                glClearColor(0, 0, 0, 0);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                glClearColor(oldClearColor[0], oldClearColor[1], oldClearColor[2], oldClearColor[3]);
-            }
-            break;
-        }
+}
+
+// internal, the pool of a key, created if it doesn't exist yet
+GlhFBOPool* getFBOPool(GlhFBOProvider *provider, GlhFBOType type, int width, int height, GLenum format) {
+    GlhFBOPool *found = findFBOPool(provider, type, width, height, format);
+    if(found != NULL) return found;
+    GlhFBOPool pool = {type, width, height, format};
+    vector_int_init(&pool.freeIds, 2);
+    vector_push(&provider->pools, &pool);
+    return vector_get_pointer_to(provider->pools, provider->pools.size - 1);
+}
 
-        return *fbo;
+void initFBOProvider(GlhFBOProvider *provider, GlhContext *ctx) {
+    vector_init(&provider->FBOs, 2, sizeof(GlhFBO));
+    vector_int_init(&provider->freeSlots, 2);
+    vector_init(&provider->pools, 2, sizeof(GlhFBOPool));
+    provider->ctx = ctx;
+    glfwGetFramebufferSize(ctx->window, &provider->width, &provider->height);
+    provider->resizePending = false;
+    provider->generation = 0;
+}
+
+void freeFBOProvider(GlhFBOProvider *provider) {
+    for(int i = 0; i < provider->FBOs.size; i++) {
+        GlhFBO fbo = vector_get(provider->FBOs.data, i, GlhFBO);
+        if(fbo.alive) GlhDeleteFBO(provider, fbo);
+    }
+    for(int i = 0; i < provider->pools.size; i++) {
+        vector_int_free(vector_get(provider->pools.data, i, GlhFBOPool).freeIds);
     }
+    vector_free(provider->FBOs);
+    vector_int_free(provider->freeSlots);
+    vector_free(provider->pools);
+}
+
+// internal, create a new FBO in a free slot, inactive
+GlhFBO* createFBO(GlhFBOProvider *provider, GlhFBOType type, int width, int height, GLenum format) {
     GlhFBO fbo;
-    fbo.active = true;
+    fbo.active = false;
+    fbo.alive = true;
     fbo.type = type;
-    fbo.id = provider->FBOs.size;
+    fbo.width = width;
+    fbo.height = height;
+    fbo.format = format;
+    fbo.generation = provider->generation;
 
     switch (type) {
         case FBSizedTexture:
         {
-            int width, height;
-            glfwGetFramebufferSize(provider->ctx->window, &width, &height);
-    
             GLuint texture;
             glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
+            GlhBindTexture(texture);
             set_opengl_label(GL_TEXTURE, texture, "TEXTURE_FBO_FBSIZED");
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
             glGenerateMipmap(GL_TEXTURE_2D);
 
             unsigned int rbo;
@@ -325,7 +687,8 @@ GlhFBO GlhRequestFBO(GlhFBOProvider *provider, GlhFBOType type) {
             glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);  
 
             glGenFramebuffers(1, &fbo.FBO);
-            glBindFramebuffer(GL_FRAMEBUFFER, fbo.FBO);
+            GlhPushState();
+            GlhBindFramebuffer(fbo.FBO);
             set_opengl_label(GL_FRAMEBUFFER, fbo.FBO, "FBO_FBSIZED");
 
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
@@ -334,24 +697,192 @@ GlhFBO GlhRequestFBO(GlhFBOProvider *provider, GlhFBOType type) {
             fbo.attachments[0] = texture;
             fbo.attachments[1] = rbo;
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                printf("WARN: created incomplete FBO\n");
+            }
+            GlhPopState();
+        }
+        break;
+    }
+    if(provider->freeSlots.size > 0) {
+        fbo.id = provider->freeSlots.data[--provider->freeSlots.size];
+        vector_set(&provider->FBOs, &fbo, fbo.id);
+    } else {
+        fbo.id = provider->FBOs.size;
+        vector_push(&provider->FBOs, &fbo);
+    }
+    return vector_get_pointer_to(provider->FBOs, fbo.id);
+}
+
+GlhFBO GlhRequestFBO(GlhFBOProvider *provider, GlhFBOType type) {
+    int width, height;
+    GLenum format;
+    FBOTypeSpecifics(provider, type, &width, &height, &format);
+    GlhFBOPool *pool = getFBOPool(provider, type, width, height, format);
+
+    GlhFBO *fbo;
+    if(pool->freeIds.size > 0) {
+        fbo = vector_get_pointer_to(provider->FBOs, pool->freeIds.data[--pool->freeIds.size]);
+    } else {
+        fbo = createFBO(provider, type, width, height, format);
+    }
+    fbo->active = true;
+
+    switch (fbo->type) {
+        case FBSizedTexture:
+        {
+            // the clear color and binding are restored from the state mirror, no glGet needed
+            GlhPushState();
+            GlhBindFramebuffer(fbo->FBO);
+            GlhClearColor(0, 0, 0, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            GlhPopState();
         }
         break;
     }
-    vector_push(&provider->FBOs, &fbo);
-    return fbo;
+
+    return *fbo;
 }
 
-void GlhReleaseFBO(GlhFBOProvider provider, GlhFBO fbo) {
-    GlhFBO *pfbo = vector_get_pointer_to(provider.FBOs, fbo.id);
+void GlhReleaseFBO(GlhFBOProvider *provider, GlhFBO fbo) {
+    GlhFBO *pfbo = vector_get_pointer_to(provider->FBOs, fbo.id);
     pfbo->active = false;
+    // created before the last resize, nobody will ask for that size again
+    if(!GlhVerrifieFBO(provider, *pfbo)) {
+        GlhDeleteFBO(provider, *pfbo);
+        return;
+    }
+    GlhFBOPool *pool = getFBOPool(provider, pfbo->type, pfbo->width, pfbo->height, pfbo->format);
+    vector_int_push(&pool->freeIds, pfbo->id);
+}
+
+void GlhFBOProviderResize(GlhFBOProvider *provider, int width, int height) {
+    provider->resizePending = true;
+    provider->pendingWidth = width;
+    provider->pendingHeight = height;
+    // every new size restarts the wait
+    provider->resizeTime = glfwGetTime();
+}
+
+void GlhFBOProviderUpdate(GlhFBOProvider *provider) {
+    if(!provider->resizePending || glfwGetTime() - provider->resizeTime < GLH_FBO_RESIZE_DEBOUNCE) return;
+    provider->resizePending = false;
+    if(provider->pendingWidth == provider->width && provider->pendingHeight == provider->height) return;
+    provider->width = provider->pendingWidth;
+    provider->height = provider->pendingHeight;
+    provider->generation++;
+    // drop the pooled window sized FBOs now, the active ones go when they are released
+    for(int i = 0; i < provider->pools.size; i++) {
+        GlhFBOPool *pool = vector_get_pointer_to(provider->pools, i);
+        if(pool->type != FBSizedTexture) continue;
+        // deleting removes the id from freeIds
+        while(pool->freeIds.size > 0) {
+            GlhFBO fbo = vector_get(provider->FBOs.data, pool->freeIds.data[pool->freeIds.size - 1], GlhFBO);
+            GlhDeleteFBO(provider, fbo);
+        }
+        vector_int_free(pool->freeIds);
+        vector_splice(&provider->pools, i, 1, NULL);
+        i--;
+    }
 }
 
 void GlhFreeProgram(GlhProgram *prg) {
     // free allocated vectors
-    vector_free(prg->attributes);
-    vector_free(prg->uniforms);
-    vector_free(prg->uniformsLocation);
+    small_vector_free(&prg->attributes);
+    small_vector_free(&prg->uniforms);
+    vector_GLint_free(prg->uniformsLocation);
+    // only built once the program is finished
+    if(!prg->pending) frozen_map_free(&prg->uniformsByName);
+}
+
+GLint GlhProgramGetUniformLocation(GlhProgram *prg, char* name) {
+    GlhFinishProgram(prg);
+    GLint* location = frozen_map_get_pointer(&prg->uniformsByName, name);
+    return location != NULL ? *location : -1;
+}
+
+// floats per vertex of a text batch
+#define GLH_TEXT_BATCH_VERTEX_SIZE 9
+
+// internal, the GL objects are created lazily by the first draw
+void initTextBatch(GlhTextBatch *batch) {
+    batch->VAO = 0;
+    batch->quadCapacity = 0;
+    vector_GlhElementPtr_init(&batch->texts, 8);
+}
+
+// internal, create and map the storage of a stream buffer, for stream->regionSize bytes per region
+void createStreamStorage(GlhStreamBuffer *stream) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = stream->regionSize * GLH_STREAM_REGIONS;
+    glGenBuffers(1, &stream->buffer);
+    set_opengl_label(GL_BUFFER, stream->buffer, "BUFFER_STREAM");
+    glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+    // immutable storage is the only kind that can stay mapped while the GPU reads from it
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    stream->mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    stream->region = 0;
+    stream->offset = 0;
+    for(int i = 0; i < GLH_STREAM_REGIONS; i++) stream->fences[i] = 0;
+}
+
+// internal, block until the GPU is done with the draws that read a region
+void waitStreamRegion(GlhStreamBuffer *stream, int region) {
+    GLsync fence = stream->fences[region];
+    if(fence == 0) return;
+    // flush on the first try, a fence that was never submitted would never be signaled
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    GLenum status;
+    do {
+        status = glClientWaitSync(fence, flags, 1000000);
+        flags = 0;
+    } while(status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    stream->fences[region] = 0;
+}
+
+void GlhInitStreamBuffer(GlhStreamBuffer *stream, GLsizeiptr regionSize) {
+    stream->regionSize = regionSize;
+    createStreamStorage(stream);
+}
+
+void GlhFreeStreamBuffer(GlhStreamBuffer *stream) {
+    for(int i = 0; i < GLH_STREAM_REGIONS; i++) {
+        if(stream->fences[i] != 0) glDeleteSync(stream->fences[i]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glDeleteBuffers(1, &stream->buffer);
+    stream->mapped = NULL;
+}
+
+void GlhStreamBufferNextRegion(GlhStreamBuffer *stream) {
+    // nothing was written, nothing to wait for next time
+    if(stream->offset == 0) return;
+    stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stream->region = (stream->region + 1) % GLH_STREAM_REGIONS;
+    stream->offset = 0;
+}
+
+void* GlhStreamBufferAlloc(GlhStreamBuffer *stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr *offset) {
+    if(size > stream->regionSize) {
+        // no region could ever hold it, start over with bigger ones. the draws already submitted
+        // keep the old storage alive until they are done, GL only deletes it after that
+        GlhFreeStreamBuffer(stream);
+        while(stream->regionSize < size) stream->regionSize *= 2;
+        createStreamStorage(stream);
+    }
+    GLsizeiptr start = (stream->offset + alignment - 1) / alignment * alignment;
+    if(start + size > stream->regionSize) {
+        // the rest of the frame goes in the next region
+        GlhStreamBufferNextRegion(stream);
+        start = 0;
+    }
+    // first write to the region since it was left, the GPU might still be reading it
+    if(start == 0) waitStreamRegion(stream, stream->region);
+    stream->offset = start + size;
+    *offset = stream->region * stream->regionSize + start;
+    return stream->mapped + *offset;
 }
 
 void GlhInitContext(GlhContext *ctx, int windowWidth, int windowHeight, char* windowTitle) {
@@ -366,6 +897,8 @@ void GlhInitContext(GlhContext *ctx, int windowWidth, int windowHeight, char* wi
     glfwMakeContextCurrent(ctx->window);
     glewInit();
     glfwSwapInterval(1);
+    // fresh context, everything is at its default
+    GlhResetStateCache();
     // set camera data
     ctx->camera.fov = glm_rad(90);
     glm_vec3_zero(ctx->camera.position);
@@ -373,35 +906,74 @@ void GlhInitContext(GlhContext *ctx, int windowWidth, int windowHeight, char* wi
     ctx->camera.zNear = 0.1;
     ctx->camera.zFar = 100;
     ctx->camera.perspective = true;
+    ctx->camera.viewDirty = true;
+    ctx->camera.projectionDirty = true;
     // init children vector
-    vector_init(&ctx->children, 2, sizeof(void*));
-    vector_init(&ctx->FBOProvider.FBOs, 2, sizeof(GlhFBO));
-    ctx->FBOProvider.ctx = ctx;
+    vector_GlhElementPtr_init(&ctx->children, 2);
+    vector_GlhRenderQueueItem_init(&ctx->renderQueue.items, 2);
+    vector_GlhRenderQueueItem_init(&ctx->renderQueue.sortBuffer, 2);
+    initTextBatch(&ctx->textBatch);
+    GlhInitStreamBuffer(&ctx->stream, GLH_STREAM_REGION_SIZE);
+    initFBOProvider(&ctx->FBOProvider, ctx);
+    transform_store_init(&ctx->transforms);
+    bvh_init(&ctx->bvh);
+    vector_int_init(&ctx->visible, 16);
+    // camera block, filled by the first GlhUpdateContextTransforms
+    glGenBuffers(1, &ctx->cameraBuffer);
+    set_opengl_label(GL_BUFFER, ctx->cameraBuffer, "BUFFER_CAMERA");
+    glBindBuffer(GL_UNIFORM_BUFFER, ctx->cameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(GlhCameraBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, GLH_CAMERA_BLOCK_BINDING, ctx->cameraBuffer);
     // get window width and height
     int width, height;
     glfwGetWindowSize(ctx->window, &width, &height);
     // set viewport
     // TODO move those kind of lines to some kind of hook to a glfw resize event
     glViewport(0, 0, width, height);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
+    GlhSetBlend(true);
+    GlhBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GlhSetDepthTest(true);
     // mostly for text with slanted fonts because most of the letters
     // will have the same z, and which would end up in a failing depth
     // test with the regular GL_LESS depth function
-    glDepthFunc(GL_LEQUAL);
+    GlhDepthFunc(GL_LEQUAL);
     #undef OPT
 
     _makeGlobalShaderReady();
 }
 
 void GlhFreeContext(GlhContext *ctx) {
-    vector_free(ctx->children);
-    vector_free(ctx->FBOProvider.FBOs);
+    vector_GlhElementPtr_free(ctx->children);
+    vector_GlhRenderQueueItem_free(ctx->renderQueue.items);
+    vector_GlhRenderQueueItem_free(ctx->renderQueue.sortBuffer);
+    vector_GlhElementPtr_free(ctx->textBatch.texts);
+    GlhFreeStreamBuffer(&ctx->stream);
+    freeFBOProvider(&ctx->FBOProvider);
+    transform_store_free(&ctx->transforms);
+    bvh_free(&ctx->bvh);
+    vector_int_free(ctx->visible);
+    glDeleteBuffers(1, &ctx->cameraBuffer);
 }
 
 void GlhContextAppendChild(GlhContext *ctx, GlhElement *child) {
-    vector_push(&ctx->children, &child);
+    child->any.contextIndex = ctx->children.size;
+    vector_GlhElementPtr_push(&ctx->children, child);
+    transform_store_add(&ctx->transforms);
+}
+
+void GlhContextAppendChildTo(GlhContext *ctx, GlhElement *parent, GlhElement *child) {
+    int index = transform_store_insert_child(&ctx->transforms, parent->any.contextIndex);
+    // same move in the children, to keep the indices in sync with the store
+    vector_GlhElementPtr_push(&ctx->children, NULL);
+    GlhElementPtr* children = ctx->children.data;
+    memmove(children + index + 1, children + index, (ctx->children.size - 1 - index) * sizeof(GlhElementPtr));
+    children[index] = child;
+    for(int i = index; i < ctx->children.size; i++) children[i]->any.contextIndex = i;
+}
+
+GlhElement* GlhContextGetParent(GlhContext *ctx, GlhElement *el) {
+    int parent = ctx->transforms.parents[el->any.contextIndex];
+    return parent < 0 ? NULL : vector_GlhElementPtr_get(&ctx->children, parent);
 }
 
 void GlhComputeContextViewMatrix(GlhContext *ctx) {
@@ -416,6 +988,7 @@ void GlhComputeContextViewMatrix(GlhContext *ctx) {
     glm_rotate_y(ctx->cachedViewMatrix, rotation[1], ctx->cachedViewMatrix);
     glm_rotate_z(ctx->cachedViewMatrix, rotation[2], ctx->cachedViewMatrix);
     glm_translate(ctx->cachedViewMatrix, translation);
+    ctx->transforms.viewProjectionDirty = true;
 }
 
 void GlhComputeContextProjectionMatrix(GlhContext *ctx) { 
@@ -430,54 +1003,206 @@ void GlhComputeContextProjectionMatrix(GlhContext *ctx) {
         float f = tanf(M_PI_2 - 0.5 * ctx->camera.fov) * aspect;
         glm_ortho(-f, f, -1, 1, ctx->camera.zNear, ctx->camera.zFar, p);
     }
+    // the view spans 2 * tan(fov / 2) units at a distance of 1 vertically in perspective, 2 units in orthographic
+    ctx->lodPixelScale = ctx->camera.perspective ? height / (2 * tanf(0.5 * ctx->camera.fov)) : height * 0.5f;
 
     // dirty way of setting cachedProjectionMatrix to p
     glm_mat4_identity(ctx->cachedProjectionMatrix);
     glm_mat4_mul(ctx->cachedProjectionMatrix, p, ctx->cachedProjectionMatrix);
+    ctx->transforms.viewProjectionDirty = true;
+}
+
+void GlhUpdateContextMatrices(GlhContext *ctx) {
+    if(ctx->camera.projectionDirty) {
+        int width, height;
+        glfwGetFramebufferSize(ctx->window, &width, &height);
+        glViewport(0, 0, width, height);
+        GlhComputeContextProjectionMatrix(ctx);
+        ctx->camera.projectionDirty = false;
+    }
+    if(ctx->camera.viewDirty) {
+        GlhComputeContextViewMatrix(ctx);
+        ctx->camera.viewDirty = false;
+    }
+}
+
+// internal, transforms of any element
+GlhTransforms* elementTransforms(GlhElement *el) {
+    switch (el->any.type) {
+        case regular:
+            return &el->regular.transforms;
+        case text:
+            return &el->text.transforms;
+        case group:
+            return &el->group.transforms;
+    }
+    return NULL;
+}
+
+// internal, model matrix cached on any element
+float* elementModelMatrix(GlhElement *el) {
+    switch (el->any.type) {
+        case regular:
+            return (float*) el->regular.cachedModelMatrix;
+        case text:
+            return (float*) el->text.cachedModelMatrix;
+        case group:
+            return (float*) el->group.cachedModelMatrix;
+    }
+    return NULL;
+}
+
+// internal, recompute the view projection and send the camera matrices to the camera block
+void uploadCameraBlock(GlhContext *ctx) {
+    glm_mat4_mul(ctx->cachedProjectionMatrix, ctx->cachedViewMatrix, ctx->cachedViewProjectionMatrix);
+    GlhCameraBlock block;
+    glm_mat4_copy(ctx->cachedViewMatrix, block.view);
+    glm_mat4_copy(ctx->cachedProjectionMatrix, block.projection);
+    glm_mat4_copy(ctx->cachedViewProjectionMatrix, block.viewProjection);
+    glm_vec4(ctx->camera.position, 1.0, block.position);
+    glBindBuffer(GL_UNIFORM_BUFFER, ctx->cameraBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GlhCameraBlock), &block);
+}
+
+void GlhUpdateContextTransforms(GlhContext *ctx) {
+    struct TransformStore *store = &ctx->transforms;
+    // only the children whose transforms differ from the stored ones get marked dirty
+    for(int i = 0; i < ctx->children.size; i++) {
+        GlhTransforms *tsf = elementTransforms(vector_GlhElementPtr_get(&ctx->children, i));
+        transform_store_set(store, i, tsf->translation, tsf->scale, tsf->rotation, tsf->transformsOrigin);
+    }
+    transform_store_compose(store);
+    for(int i = 0; i < ctx->children.size; i++) {
+        if(!transform_store_is_dirty(store, i)) continue;
+        memcpy(elementModelMatrix(vector_GlhElementPtr_get(&ctx->children, i)), transform_store_model(store, i), sizeof(mat4));
+    }
+    // world boxes of what moved, refitting the bvh
+    for(int i = 0; i < ctx->children.size; i++) {
+        GlhElement *el = vector_GlhElementPtr_get(&ctx->children, i);
+        GlhBoundingBox local;
+        switch (el->any.type) {
+            case regular:
+                if(!transform_store_is_dirty(store, i)) continue;
+                local = el->regular.mesh->bounds;
+                break;
+            case text:
+                // the text (so its box) can change without its transforms changing
+                local = el->text.backgroundBox;
+                break;
+            case group:
+                // never drawn, index might have belonged to something else before an insertion
+                if(transform_store_is_dirty(store, i)) bvh_remove(&ctx->bvh, i);
+                continue;
+        }
+        BvhBox box;
+        glm_vec3_copy(local.start, box.min);
+        glm_vec3_copy(local.end, box.max);
+        bvh_box_transform(&box, transform_store_model(store, i), &box);
+        bvh_set(&ctx->bvh, i, &box);
+    }
+    // the shaders do view projection * model themselves, the camera only has to be sent when it moved
+    if(store->viewProjectionDirty) {
+        uploadCameraBlock(ctx);
+        store->viewProjectionDirty = false;
+    }
+    transform_store_clear_dirty(store);
+}
+
+// internal, points the iModel binding of the bound VAO to the matrices at offset in the stream buffer
+void bindInstanceMatrices(GlhContext *ctx, GLintptr offset) {
+    glBindVertexBuffer(GLH_INSTANCE_ATTRIBUTE, ctx->stream.buffer, offset, sizeof(mat4));
+}
+
+// internal, level of detail to draw obj with: the coarsest one whose error, projected on the screen, stays
+// under GLH_LOD_PIXEL_ERROR, for the model matrix's biggest scale at the distance of the center of the mesh
+int selectMeshLOD(GlhContext *ctx, GlhObject *obj) {
+    GlhMesh *mesh = obj->mesh;
+    if(mesh->lodCount <= 1) return 0;
+    float scale = 0;
+    for(int i = 0; i < 3; i++) {
+        float s = glm_vec3_norm(obj->cachedModelMatrix[i]);
+        if(s > scale) scale = s;
+    }
+    float pixels = ctx->lodPixelScale * scale;
+    if(ctx->camera.perspective) {
+        vec3 center, world;
+        glm_vec3_center(mesh->bounds.start, mesh->bounds.end, center);
+        glm_mat4_mulv3(obj->cachedModelMatrix, center, 1, world);
+        float distance = glm_vec3_distance(world, ctx->camera.position);
+        pixels /= distance > ctx->camera.zNear ? distance : ctx->camera.zNear;
+    }
+    for(int lod = mesh->lodCount - 1; lod > 0; lod--) {
+        if(mesh->lods[lod].error * pixels <= GLH_LOD_PIXEL_ERROR) return lod;
+    }
+    return 0;
+}
+
+// internal, draw a level of detail of the mesh of the bound VAO, instanced if instances isn't 0
+void drawMeshLOD(GlhMesh *mesh, int lod, int instances) {
+    GlhMeshLOD *level = &mesh->lods[lod];
+    size_t indexSize = mesh->bufferData.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    void *offset = (void*) (level->indexOffset * indexSize);
+    if(instances > 0) {
+        glDrawElementsInstanced(GL_TRIANGLES, level->indexCount, mesh->bufferData.indexType, offset, instances);
+    } else {
+        glDrawElements(GL_TRIANGLES, level->indexCount, mesh->bufferData.indexType, offset);
+    }
 }
 
 void GlhRenderObject(GlhObject *obj, GlhContext *ctx) {
+    GlhFinishProgram(obj->program);
     // use objext's shader program
-    glUseProgram(obj->program->shaderProgram);
+    GlhUseProgram(obj->program->shaderProgram);
     // set the uniforms related to the program
-    (*obj->program->setGlobalUniforms)(obj, ctx);
+    if(obj->program->setGlobalUniforms) (*obj->program->setGlobalUniforms)(obj, ctx);
     // bind objects's texture
-    glBindTexture(GL_TEXTURE_2D, obj->texture);
+    GlhBindTexture(obj->texture);
     // bind VAO
-    glBindVertexArray(obj->mesh->bufferData.VAO);
+    GlhBindVertexArray(obj->mesh->bufferData.VAO);
     // draw object
-    glDrawElements(GL_TRIANGLES, obj->mesh->bufferData.vertexCount, GL_UNSIGNED_INT, NULL);
+    if(obj->program->instanced) {
+        // the model matrix comes from the stream buffer, as a single instance
+        GLintptr offset;
+        float *matrix = GlhStreamBufferAlloc(&ctx->stream, sizeof(mat4), sizeof(mat4), &offset);
+        memcpy(matrix, obj->cachedModelMatrix, sizeof(mat4));
+        bindInstanceMatrices(ctx, offset);
+        drawMeshLOD(obj->mesh, selectMeshLOD(ctx, obj), 1);
+    } else {
+        drawMeshLOD(obj->mesh, selectMeshLOD(ctx, obj), 0);
+    }
 }
 
 void GlhRenderTextObject(GlhTextObject *tob, GlhContext *ctx) {
+    GlhFinishProgram(tob->glyphProgram);
+    GlhFinishProgram(tob->textProgram);
     // get FBO to render the text to
     GlhFBO fbo = GlhRequestFBO(&ctx->FBOProvider, FBSizedTexture);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo.FBO);
+    GlhBindFramebuffer(fbo.FBO);
 
-    glUseProgram(tob->glyphProgram->shaderProgram);
+    GlhUseProgram(tob->glyphProgram->shaderProgram);
     // set the uniforms related to the program
-    (*tob->glyphProgram->setGlobalUniforms)(tob, ctx);
+    if(tob->glyphProgram->setGlobalUniforms) (*tob->glyphProgram->setGlobalUniforms)(tob, ctx);
     // bind objects's texture
-    glBindTexture(GL_TEXTURE_2D, tob->font->texture);
+    GlhBindTexture(tob->font->texture);
     // bind VAO
-    glBindVertexArray(tob->bufferData.VAO);
+    GlhBindVertexArray(tob->bufferData.VAO);
     // draw object
     glDrawElements(GL_TRIANGLES, tob->bufferData.vertexCount, GL_UNSIGNED_INT, NULL);
     // unbind FBO
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GlhBindFramebuffer(0);
 
-    glUseProgram(tob->textProgram->shaderProgram);
+    GlhUseProgram(tob->textProgram->shaderProgram);
     // set the uniforms related to the program
-    (*tob->textProgram->setGlobalUniforms)(tob, ctx);
+    if(tob->textProgram->setGlobalUniforms) (*tob->textProgram->setGlobalUniforms)(tob, ctx);
 
-    glBindTexture(GL_TEXTURE_2D, fbo.attachments[0]);
+    GlhBindTexture(fbo.attachments[0]);
     // bind background VAO
-    glBindVertexArray(tob->backgroundQuadBufferData.VAO);
+    GlhBindVertexArray(tob->backgroundQuadBufferData.VAO);
     // draw background
     glDrawElements(GL_TRIANGLES, tob->backgroundQuadBufferData.vertexCount, GL_UNSIGNED_INT, NULL);
 
-    GlhReleaseFBO(ctx->FBOProvider, fbo);
+    GlhReleaseFBO(&ctx->FBOProvider, fbo);
 }
 
 void GlhRenderElement(GlhElement *el, GlhContext *ctx) {
@@ -489,17 +1214,306 @@ void GlhRenderElement(GlhElement *el, GlhContext *ctx) {
         case text:
             GlhRenderTextObject(&el->text, ctx);
             break;
+        case group:
+            break;
+    }
+}
+
+// internal, same as GlhRenderObject but counts the binds that weren't filtered by the state cache,
+// the level of detail was already chosen when building the queue
+void _renderObjectSorted(GlhObject *obj, int lod, GlhContext *ctx) {
+    if(GlhUseProgram(obj->program->shaderProgram)) ctx->renderStats.programBinds++;
+    // uniforms are per object, always set them
+    if(obj->program->setGlobalUniforms) (*obj->program->setGlobalUniforms)(obj, ctx);
+    if(GlhBindTexture(obj->texture)) ctx->renderStats.textureBinds++;
+    if(GlhBindVertexArray(obj->mesh->bufferData.VAO)) ctx->renderStats.VAOBinds++;
+    drawMeshLOD(obj->mesh, lod, 0);
+    ctx->renderStats.drawCalls++;
+    ctx->renderStats.triangles += obj->mesh->lods[lod].indexCount / 3;
+}
+
+// internal, whether two objects can be drawn by the same instanced draw call
+bool canInstanceTogether(GlhObject *a, GlhObject *b) {
+    return a->program == b->program && a->texture == b->texture && a->mesh == b->mesh;
+}
+
+// internal, draws the run of count objects starting at items (all sharing program, texture, mesh and level of detail)
+// in one call, their matrices are already in the stream buffer starting at offset
+void _renderInstancedRun(GlhRenderQueueItem *items, int count, GLintptr offset, GlhContext *ctx) {
+    GlhObject *obj = &items[0].element->regular;
+    if(GlhUseProgram(obj->program->shaderProgram)) ctx->renderStats.programBinds++;
+    // per program uniforms only, the model matrices are instance attributes
+    if(obj->program->setGlobalUniforms) (*obj->program->setGlobalUniforms)(obj, ctx);
+    if(GlhBindTexture(obj->texture)) ctx->renderStats.textureBinds++;
+    if(GlhBindVertexArray(obj->mesh->bufferData.VAO)) ctx->renderStats.VAOBinds++;
+    bindInstanceMatrices(ctx, offset);
+    drawMeshLOD(obj->mesh, items[0].lod, count);
+    ctx->renderStats.drawCalls++;
+    ctx->renderStats.instances += count;
+    ctx->renderStats.triangles += obj->mesh->lods[items[0].lod].indexCount / 3 * count;
+}
+
+// internal, number of quads a text object adds to a batch
+int textBatchQuads(GlhTextObject *tob) {
+    return (tob->backgroundColor[3] > 0) + tob->verticies.size / 12;
+}
+
+// internal, writes a quad to out given its 4 local corners (in the same order as the glyph quads), returns the end of it.
+// out is mapped memory, only written in order and never read
+float* pushTextBatchQuad(float *out, mat4 model, float *corners, float *texCoords, vec4 color) {
+    for(int v = 0; v < 4; v++) {
+        glm_mat4_mulv3(model, corners + v * 3, 1.0, out);
+        glm_vec4_copy(color, out + 3);
+        out[7] = texCoords[v * 2 + 0];
+        out[8] = texCoords[v * 2 + 1];
+        out += GLH_TEXT_BATCH_VERTEX_SIZE;
+    }
+    return out;
+}
+
+// internal, writes the background then the glyphs of a text object to out, so they blend in that order
+float* appendTextObjectToBatch(float *out, GlhTextObject *tob) {
+    if(tob->backgroundColor[3] > 0) {
+        GlhBoundingBox *box = &tob->backgroundBox;
+        float corners[12] = {
+            box->start[0], box->start[1], 0,
+            box->end[0]  , box->start[1], 0,
+            box->start[0], box->end[1]  , 0,
+            box->end[0]  , box->end[1]  , 0
+        };
+        // negative texCoords mark a quad that doesn't sample the atlas
+        float texCoords[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+        out = pushTextBatchQuad(out, tob->cachedModelMatrix, corners, texCoords, tob->backgroundColor);
+    }
+    int quads = tob->verticies.size / 12;
+    for(int i = 0; i < quads; i++) {
+        out = pushTextBatchQuad(out, tob->cachedModelMatrix, tob->verticies.data + i * 12, tob->texCoords.data + i * 8, tob->color);
+    }
+    return out;
+}
+
+// internal, create the VAO / index buffer, and make sure the index buffer has indices for quads quads
+void prepareTextBatchBuffers(GlhTextBatch *batch, int quads) {
+    if(batch->VAO == 0) {
+        glGenVertexArrays(1, &batch->VAO);
+        glGenBuffers(1, &batch->indexBuffer);
+        set_opengl_label(GL_VERTEX_ARRAY, batch->VAO, "VAO_TEXT_BATCH");
+        set_opengl_label(GL_BUFFER, batch->indexBuffer, "BUFFER_TEXT_BATCH_INDICIES");
+        GlhBindVertexArray(batch->VAO);
+        // only the layout, the vertices are somewhere else in the stream buffer every draw
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+        glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(float));
+        for(int i = 0; i < 3; i++) {
+            glVertexAttribBinding(i, 0);
+            glEnableVertexAttribArray(i);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->indexBuffer);
+    }
+    if(quads <= batch->quadCapacity) return;
+    int capacity = batch->quadCapacity > 0 ? batch->quadCapacity : 64;
+    while(capacity < quads) capacity *= 2;
+    // same pattern as the text object meshes, 0, 1, 2, 1, 3, 2 then 4, 5, 6, 5, 7, 6...
+    unsigned int *indices = malloc(capacity * 6 * sizeof(unsigned int));
+    for(int i = 0; i < capacity; i++) {
+        unsigned int vi = i * 4;
+        unsigned int *q = indices + i * 6;
+        q[0] = vi + 0; q[1] = vi + 1; q[2] = vi + 2;
+        q[3] = vi + 1; q[4] = vi + 3; q[5] = vi + 2;
+    }
+    GlhBindVertexArray(batch->VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * 6 * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    free(indices);
+    batch->quadCapacity = capacity;
+}
+
+// internal, draws the text objects gathered in ctx->textBatch, one draw call per run of consecutive
+// objects using the same font. runs are drawn in order so the back to front order holds across fonts
+void renderTextBatches(GlhContext *ctx) {
+    GlhTextBatch *batch = &ctx->textBatch;
+    int n = batch->texts.size;
+    if(n == 0) return;
+    GlhProgram *prg = &GlobalShaders.batchedText;
+    GlhFinishProgram(prg);
+    for(int i = 0, end; i < n; i = end) {
+        GlhFont *font = batch->texts.data[i]->text.font;
+        // size of the run first, so its vertices can be written straight into the stream buffer
+        int quads = 0;
+        for(end = i; end < n && batch->texts.data[end]->text.font == font; end++) {
+            quads += textBatchQuads(&batch->texts.data[end]->text);
+        }
+        if(quads == 0) continue;
+        GLsizei stride = GLH_TEXT_BATCH_VERTEX_SIZE * sizeof(float);
+        GLintptr offset = 0;
+        float *out = GlhStreamBufferAlloc(&ctx->stream, quads * 4 * stride, sizeof(vec4), &offset);
+        for(int j = i; j < end; j++) {
+            out = appendTextObjectToBatch(out, &batch->texts.data[j]->text);
+        }
+        prepareTextBatchBuffers(batch, quads);
+        if(GlhUseProgram(prg->shaderProgram)) ctx->renderStats.programBinds++;
+        if(GlhBindTexture(font->texture)) ctx->renderStats.textureBinds++;
+        if(GlhBindVertexArray(batch->VAO)) ctx->renderStats.VAOBinds++;
+        glBindVertexBuffer(0, ctx->stream.buffer, offset, stride);
+        glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_INT, NULL);
+        ctx->renderStats.drawCalls++;
+    }
+    batch->texts.size = 0;
+}
+
+// internal, distance from the camera to the origin of a model matrix, quantized to 16 bits over [0, zFar]
+unsigned long quantizedDepth(GlhContext *ctx, mat4 model) {
+    vec4 viewPos;
+    glm_mat4_mulv(ctx->cachedViewMatrix, model[3], viewPos);
+    float d = -viewPos[2] / ctx->camera.zFar;
+    d = d < 0 ? 0 : d > 1 ? 1 : d;
+    return (unsigned long)(d * 0xffff);
+}
+
+// internal, sort key of an element (lod is only used by regular objects):
+// regular objects: [0][program:15][texture:16][VAO:16][lod:3][depth:13], sorted by state, level of detail (so
+//                  instanced runs don't get split) then front to back
+// text objects:    [1][inverted depth:16][program:15][texture:16][VAO:16], after every regular object, back to front
+// names are truncated to their low bits, which only costs sorting quality, never correctness
+unsigned long renderSortKey(GlhContext *ctx, GlhElement *el, int lod) {
+    switch (el->any.type) {
+        case regular:
+        {
+            GlhObject *obj = &el->regular;
+            return ((unsigned long)(obj->program->shaderProgram & 0x7fff) << 48)
+                | ((unsigned long)(obj->texture & 0xffff) << 32)
+                | ((unsigned long)(obj->mesh->bufferData.VAO & 0xffff) << 16)
+                | ((unsigned long)lod << 13)
+                | (quantizedDepth(ctx, obj->cachedModelMatrix) >> 3);
+        }
+        case text:
+        {
+            GlhTextObject *tob = &el->text;
+            return (1UL << 63)
+                | ((0xffff - quantizedDepth(ctx, tob->cachedModelMatrix)) << 47)
+                | ((unsigned long)(tob->glyphProgram->shaderProgram & 0x7fff) << 32)
+                | ((unsigned long)(tob->font->texture & 0xffff) << 16)
+                | (unsigned long)(tob->bufferData.VAO & 0xffff);
+        }
+        case group:
+            break;
     }
+    return 0;
+}
+
+// internal, LSD radix sort of the queue items by key, 8 bits at a time (stable)
+void sortRenderQueue(GlhRenderQueue *queue) {
+    int n = queue->items.size;
+    vector_GlhRenderQueueItem_reserve(&queue->sortBuffer, n);
+    GlhRenderQueueItem* src = queue->items.data;
+    GlhRenderQueueItem* dst = queue->sortBuffer.data;
+    for(int shift = 0; shift < 64; shift += 8) {
+        int counts[256] = {};
+        for(int i = 0; i < n; i++) counts[(src[i].key >> shift) & 0xff]++;
+        // every key has the same digit, nothing to do for this pass
+        if(counts[(src[0].key >> shift) & 0xff] == n) continue;
+        int offset = 0;
+        for(int d = 0; d < 256; d++) {
+            int c = counts[d];
+            counts[d] = offset;
+            offset += c;
+        }
+        for(int i = 0; i < n; i++) dst[counts[(src[i].key >> shift) & 0xff]++] = src[i];
+        GlhRenderQueueItem* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    // the sorted items might have ended in the scratch buffer
+    if(src != queue->items.data) memcpy(queue->items.data, src, n * sizeof(GlhRenderQueueItem));
 }
 
 void GlhRenderContext(GlhContext *ctx) {
     // clear screen and depth buffer (for depth testing)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // recreate window sized FBOs if a resize settled
+    GlhFBOProviderUpdate(&ctx->FBOProvider);
+    // camera matrices, only if something flagged them dirty since last frame
+    GlhUpdateContextMatrices(ctx);
+    // model matrices of what moved since last frame
+    GlhUpdateContextTransforms(ctx);
+    GlhRenderStats stats = {};
+    ctx->renderStats = stats;
+    // build and sort this frame's queue
+    GlhRenderQueue *queue = &ctx->renderQueue;
+    queue->items.size = 0;
+    vector_GlhRenderQueueItem_reserve(&queue->items, ctx->children.size);
+    // only what is (at least partially) inside the frustum goes in the queue, groups are never in the bvh
+    float planes[6][4];
+    frustum_planes_from_matrix((float*) ctx->cachedViewProjectionMatrix, planes);
+    vector_int_reserve(&ctx->visible, ctx->children.size);
+    ctx->visible.size = bvh_query_planes(&ctx->bvh, planes, ctx->visible.data);
+    for(int i = 0; i < ctx->visible.size; i++) {
+        GlhRenderQueueItem item;
+        item.element = vector_GlhElementPtr_get(&ctx->children, ctx->visible.data[i]);
+        item.lod = 0;
+        if(item.element->any.type == regular) {
+            // only the programs of what is visible have to be ready, the others can still be compiling
+            GlhFinishProgram(item.element->regular.program);
+            item.lod = selectMeshLOD(ctx, &item.element->regular);
+        }
+        item.key = renderSortKey(ctx, item.element, item.lod);
+        vector_GlhRenderQueueItem_push(&queue->items, item);
+    }
     for(int i = 0; i < ctx->children.size; i++) {
-        GlhElement* el = vector_get(ctx->children.data, i, void*);
-        
-        GlhRenderElement(el, ctx);
+        if(vector_GlhElementPtr_get(&ctx->children, i)->any.type != group) ctx->renderStats.culled++;
+    }
+    ctx->renderStats.culled -= ctx->visible.size;
+    if(queue->items.size > 1) sortRenderQueue(queue);
+    // write the model matrices of every object using an instanced program, in queue order, straight
+    // into the stream buffer, so the whole frame needs a single allocation and each run just starts further in it
+    int instanceCount = 0;
+    for(int i = 0; i < queue->items.size; i++) {
+        GlhElement* el = queue->items.data[i].element;
+        if(el->any.type == regular && el->regular.program->instanced) instanceCount++;
+    }
+    GLintptr instanceOffset = 0;
+    if(instanceCount > 0) {
+        float *matrices = GlhStreamBufferAlloc(&ctx->stream, instanceCount * sizeof(mat4), sizeof(mat4), &instanceOffset);
+        for(int i = 0; i < queue->items.size; i++) {
+            GlhElement* el = queue->items.data[i].element;
+            if(el->any.type != regular || !el->regular.program->instanced) continue;
+            memcpy(matrices, el->regular.cachedModelMatrix, sizeof(mat4));
+            matrices += 16;
+        }
     }
+    int baseInstance = 0;
+    // submit, redundant binds between consecutive draws are filtered by the state cache
+    for(int i = 0; i < queue->items.size; i++) {
+        GlhElement* el = queue->items.data[i].element;
+        switch (el->any.type) {
+            case regular:
+                if(el->regular.program->instanced) {
+                    // the queue is sorted by program, texture, VAO and level of detail, so objects sharing them are next to each other
+                    int count = 1;
+                    while(i + count < queue->items.size) {
+                        GlhElement* next = queue->items.data[i + count].element;
+                        if(next->any.type != regular || !canInstanceTogether(&el->regular, &next->regular)) break;
+                        if(queue->items.data[i + count].lod != queue->items.data[i].lod) break;
+                        count++;
+                    }
+                    _renderInstancedRun(&queue->items.data[i], count, instanceOffset + baseInstance * sizeof(mat4), ctx);
+                    baseInstance += count;
+                    i += count - 1;
+                } else {
+                    _renderObjectSorted(&el->regular, queue->items.data[i].lod, ctx);
+                }
+                break;
+            case text:
+                // text objects are sorted last, gather them to draw runs of the same font batched
+                vector_GlhElementPtr_push(&ctx->textBatch.texts, el);
+                break;
+            case group:
+                break;
+        }
+    }
+    renderTextBatches(ctx);
+    // everything this frame reads from the stream buffer is submitted
+    GlhStreamBufferNextRegion(&ctx->stream);
 }
 
 // internal, used to avoid repeats
@@ -509,38 +1523,277 @@ void setAttribute(GLuint buffer, GLuint location, int comp) {
     glEnableVertexAttribArray(location);
 }
 
-void GlhInitMesh(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], vec3 indices[], int indicesCount, vec2 texcoords[], int texcoordsCount) {
+// internal, makes the iModel attribute of the bound VAO read one matrix per instance from the binding
+// GLH_INSTANCE_ATTRIBUTE. the buffer is bound there at draw time, as the matrices move around the stream buffer
+void setInstanceAttribute() {
+    // a mat4 attribute is 4 vec4 columns, each with its own location
+    for(int i = 0; i < 4; i++) {
+        GLuint location = GLH_INSTANCE_ATTRIBUTE + i;
+        glVertexAttribFormat(location, 4, GL_FLOAT, GL_FALSE, i * sizeof(vec4));
+        glVertexAttribBinding(location, GLH_INSTANCE_ATTRIBUTE);
+        glEnableVertexAttribArray(location);
+    }
+    glVertexBindingDivisor(GLH_INSTANCE_ATTRIBUTE, 1);
+}
+
+// internal, map the whole buffer bound to target (just allocated with size bytes) to write it once
+void* mapNewBuffer(GLenum target, GLsizeiptr size) {
+    glBufferData(target, size, NULL, GL_STATIC_DRAW);
+    // mapping 0 bytes is an error
+    if(size == 0) return NULL;
+    return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+// internal, create the index buffer of the bound VAO of a mesh from count indices, narrowed to 16 bits
+// when every index of a mesh of vertexCount vertices fits in them (half the memory and index fetching)
+void uploadMeshIndices(GlhMesh *mesh, const unsigned int *indices, int count, int vertexCount) {
+    glGenBuffers(1, &mesh->bufferData.indexsBuffer);
+    set_opengl_label(GL_BUFFER, mesh->bufferData.indexsBuffer, "BUFFER_INDICIES");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->bufferData.indexsBuffer);
+    if(vertexCount <= 0x10000) {
+        mesh->bufferData.indexType = GL_UNSIGNED_SHORT;
+        unsigned short *narrow = mapNewBuffer(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned short));
+        for(int i = 0; i < count; i++) narrow[i] = indices[i];
+        if(count > 0) glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    } else {
+        // already in the right format, straight from the caller's memory
+        mesh->bufferData.indexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    }
+    // a single level of detail, the whole buffer
+    mesh->bufferData.vertexCount = count;
+    mesh->lodCount = 1;
+    mesh->lods[0].indexOffset = 0;
+    mesh->lods[0].indexCount = count;
+    mesh->lods[0].error = 0;
+}
+
+// internal, every level of detail of indexCount indices one after the other in a malloc'd array, filling lods
+// (and *lodCount) and writing the total count to *total. size is the size of the mesh (the diagonal of its bounds). each level aims for half the triangles of the previous
+// one, the chain stops once simplifying doesn't remove at least a quarter of them (mostly borders and seams left)
+unsigned int* buildMeshLODs(float size, const float *positions, int stride, int vertexCount, const unsigned int *indices, int indexCount, bool optimize, GlhMeshLOD lods[GLH_MAX_LODS], int *lodCount, int *total) {
+    // levels can't be bigger than the full mesh, there is room for all of them
+    unsigned int *all = malloc(GLH_MAX_LODS * (indexCount > 0 ? indexCount : 1) * sizeof(unsigned int));
+    memcpy(all, indices, indexCount * sizeof(unsigned int));
+    lods[0].indexOffset = 0;
+    lods[0].indexCount = indexCount;
+    lods[0].error = 0;
+    *lodCount = 1;
+    int count = indexCount;
+    // coarser levels are allowed to move as much as a tenth of the size of the mesh, they are only drawn
+    // when that is under a pixel anyway
+    float maxError = 0.1f * size;
+    while(*lodCount < GLH_MAX_LODS) {
+        GlhMeshLOD *previous = &lods[*lodCount - 1];
+        float error;
+        int target = previous->indexCount / 6 * 3;
+        int simplified = mesh_simplify(positions, stride, vertexCount, all + previous->indexOffset, previous->indexCount, target, maxError, all + count, &error);
+        if(simplified == 0 || simplified > previous->indexCount * 3 / 4) break;
+        if(optimize) mesh_optimize_vertex_cache(all + count, simplified, vertexCount);
+        GlhMeshLOD *level = &lods[(*lodCount)++];
+        level->indexOffset = count;
+        level->indexCount = simplified;
+        // simplified from the previous level, so the errors add up
+        level->error = previous->error + error;
+        count += simplified;
+    }
+    *total = count;
+    return all;
+}
+
+// internal, uploadMeshIndices with every level of detail (see buildMeshLODs) in the same index buffer,
+// so drawing one is only a different range of it
+void uploadMeshLODs(GlhMesh *mesh, const float *positions, int stride, int vertexCount, const unsigned int *indices, int indexCount, bool optimize) {
+    GlhMeshLOD lods[GLH_MAX_LODS];
+    int lodCount, total;
+    float size = glm_vec3_distance(mesh->bounds.start, mesh->bounds.end);
+    unsigned int *all = buildMeshLODs(size, positions, stride, vertexCount, indices, indexCount, optimize, lods, &lodCount, &total);
+    uploadMeshIndices(mesh, all, total, vertexCount);
+    free(all);
+    // uploadMeshIndices sets up a single level spanning the whole buffer
+    memcpy(mesh->lods, lods, sizeof(lods));
+    mesh->lodCount = lodCount;
+    mesh->bufferData.vertexCount = lods[0].indexCount;
+}
+
+// internal, set the attributes of the bound VAO of a mesh, once its buffers are created
+void setMeshAttributes(GlhMesh *mesh) {
+    // all read from the interleaved buffer at binding 0
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(GlhMeshVertex, position));
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(GlhMeshVertex, normal));
+    glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(GlhMeshVertex, texCoord));
+    for(int i = 0; i < 3; i++) {
+        glVertexAttribBinding(i, 0);
+        glEnableVertexAttribArray(i);
+    }
+    glBindVertexBuffer(0, mesh->bufferData.vertexBuffer, 0, sizeof(GlhMeshVertex));
+    // unused unless the mesh is drawn by an instanced program
+    setInstanceAttribute();
+    // bind indices buffer to VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->bufferData.indexsBuffer);
+}
+
+// internal, creates and fills the vertex buffer of a mesh from its vectors
+void uploadMeshVertices(GlhMesh *mesh) {
+    // a single interleaved buffer, the vectors are interleaved straight into the mapped buffer
+    // instead of being flattened into temporary arrays first
+    glGenBuffers(1, &mesh->bufferData.vertexBuffer);
+    set_opengl_label(GL_BUFFER, mesh->bufferData.vertexBuffer, "BUFFER_VERTICIES");
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->bufferData.vertexBuffer);
+    int count = mesh->verticies.size;
+    GlhMeshVertex *vertices = mapNewBuffer(GL_ARRAY_BUFFER, count * sizeof(GlhMeshVertex));
+    for(int i = 0; i < count; i++) {
+        GlhMeshVertex *v = &vertices[i];
+        glm_vec3_copy(vector_get(mesh->verticies.data, i, vec3), v->position);
+        if(i < mesh->normals.size) glm_vec3_copy(vector_get(mesh->normals.data, i, vec3), v->normal);
+        else glm_vec3_zero(v->normal);
+        // the texcoords might not have been given for every vertex
+        if(i < mesh->texCoords.size) glm_vec2_copy(vector_get(mesh->texCoords.data, i, vec2), v->texCoord);
+        else glm_vec2_zero(v->texCoord);
+    }
+    if(count > 0) glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+// internal, mesh_data_optimize on the CPU copy of a mesh (before it is uploaded): the triangles are reordered for
+// the post transform cache and the vectors for fetch locality. texCoords ends up with one per vertex
+void optimizeMeshVectors(GlhMesh *mesh, float *acmrBefore, float *acmrAfter) {
+    int count = mesh->verticies.size;
+    struct MeshData data = {};
+    data.vertices = malloc((count > 0 ? count : 1) * sizeof(MeshVertex));
+    data.vertexCount = count;
+    // reordered in place, the mesh keeps them
+    data.indices = mesh->indexes.data;
+    data.indexCount = mesh->indexes.size * 3;
+    for(int i = 0; i < count; i++) {
+        MeshVertex *v = &data.vertices[i];
+        glm_vec3_copy(vector_get(mesh->verticies.data, i, vec3), v->position);
+        if(i < mesh->normals.size) glm_vec3_copy(vector_get(mesh->normals.data, i, vec3), v->normal);
+        else glm_vec3_zero(v->normal);
+        if(i < mesh->texCoords.size) glm_vec2_copy(vector_get(mesh->texCoords.data, i, vec2), v->texCoord);
+        else glm_vec2_zero(v->texCoord);
+    }
+    mesh_data_optimize(&data, acmrBefore, acmrAfter);
+    mesh->normals.size = 0;
+    mesh->texCoords.size = 0;
+    for(int i = 0; i < count; i++) {
+        MeshVertex *v = &data.vertices[i];
+        glm_vec3_copy(v->position, vector_get(mesh->verticies.data, i, vec3));
+        vector_push(&mesh->normals, v->normal);
+        vector_push(&mesh->texCoords, v->texCoord);
+    }
+    free(data.vertices);
+}
+
+void GlhInitMesh(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], vec3 indices[], int indicesCount, vec2 texcoords[], int texcoordsCount, int flags) {
+    unsigned int *integers = malloc(indicesCount * 3 * sizeof(unsigned int));
+    for(int i = 0; i < indicesCount; i++) {
+        for(int j = 0; j < 3; j++) integers[i * 3 + j] = (unsigned int) indices[i][j];
+    }
+    GlhInitMeshIndexed(mesh, verticies, verticiesCount, normals, integers, indicesCount * 3, texcoords, texcoordsCount, flags);
+    free(integers);
+}
+
+void GlhInitMeshIndexed(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], unsigned int indices[], int indicesCount, vec2 texcoords[], int texcoordsCount, int flags) {
     GlhMeshBufferData data = {};
     // zeroify bufferData
     mesh->bufferData = data;
     // initialize and set the vectors
     vector_init(&mesh->verticies, verticiesCount, sizeof(vec3));
     vector_init(&mesh->normals, verticiesCount, sizeof(vec3));
-    vector_init(&mesh->indexes, indicesCount, sizeof(vec3));
+    vector_init(&mesh->indexes, indicesCount / 3, 3 * sizeof(unsigned int));
     vector_init(&mesh->texCoords, texcoordsCount, sizeof(vec2));
     vector_push_array(&mesh->verticies, verticies, verticiesCount);
     vector_push_array(&mesh->normals, normals, verticiesCount);
-    vector_push_array(&mesh->indexes, indices, indicesCount);
+    vector_push_array(&mesh->indexes, indices, indicesCount / 3);
     vector_push_array(&mesh->texCoords, texcoords, texcoordsCount);
+    // the mesh has its own copy of everything, reordered in place
+    if(flags & GLH_MESH_OPTIMIZE) {
+        float before, after;
+        optimizeMeshVectors(mesh, &before, &after);
+        printf("mesh: %i triangles, acmr %.3f -> %.3f\n", indicesCount / 3, before, after);
+    }
+    // local bounds, for culling
+    glm_vec3_broadcast(verticiesCount > 0 ? INFINITY : 0, mesh->bounds.start);
+    glm_vec3_broadcast(verticiesCount > 0 ? -INFINITY : 0, mesh->bounds.end);
+    for(int i = 0; i < verticiesCount; i++) {
+        glm_vec3_minv(mesh->bounds.start, verticies[i], mesh->bounds.start);
+        glm_vec3_maxv(mesh->bounds.end, verticies[i], mesh->bounds.end);
+    }
     // create and bind VAO
     glGenVertexArrays(1, &mesh->bufferData.VAO);
     set_opengl_label(GL_VERTEX_ARRAY, mesh->bufferData.VAO, "VAO");
-    glBindVertexArray(mesh->bufferData.VAO);
+    GlhBindVertexArray(mesh->bufferData.VAO);
     // generate and fill VBOs
-    GlhGenerateMeshBuffers(mesh);
-    // set attributes to VAO
-    setAttribute(mesh->bufferData.vertexBuffer, 0, 3);
-    setAttribute(mesh->bufferData.normalBuffer, 1, 3);
-    setAttribute(mesh->bufferData.tcoordBuffer, 2, 2);
-    // bind indices buffer to VAO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->bufferData.indexsBuffer);
+    uploadMeshVertices(mesh);
+    if((flags & GLH_MESH_LODS) && verticiesCount > 0) {
+        // from the mesh's copy, the vertices may have been reordered
+        uploadMeshLODs(mesh, mesh->verticies.data, sizeof(vec3), verticiesCount, mesh->indexes.data, mesh->indexes.size * 3, flags & GLH_MESH_OPTIMIZE);
+    } else {
+        uploadMeshIndices(mesh, mesh->indexes.data, mesh->indexes.size * 3, verticiesCount);
+    }
+    setMeshAttributes(mesh);
+}
+
+void GlhInitMeshFromData(GlhMesh *mesh, struct MeshData *data, int flags) {
+    GlhMeshBufferData bufferData = {};
+    mesh->bufferData = bufferData;
+    // no CPU copy, same state as after GlhMeshDropCPUData
+    vector_init(&mesh->verticies, 1, sizeof(vec3));
+    vector_init(&mesh->normals, 1, sizeof(vec3));
+    vector_init(&mesh->indexes, 1, 3 * sizeof(unsigned int));
+    vector_init(&mesh->texCoords, 1, sizeof(vec2));
+    glm_vec3_copy(data->min, mesh->bounds.start);
+    glm_vec3_copy(data->max, mesh->bounds.end);
+    glGenVertexArrays(1, &mesh->bufferData.VAO);
+    set_opengl_label(GL_VERTEX_ARRAY, mesh->bufferData.VAO, "VAO");
+    GlhBindVertexArray(mesh->bufferData.VAO);
+    // already in the GPU layout, uploaded straight from data (from the file mapping if it was mapped)
+    glGenBuffers(1, &mesh->bufferData.vertexBuffer);
+    set_opengl_label(GL_BUFFER, mesh->bufferData.vertexBuffer, "BUFFER_VERTICIES");
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->bufferData.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, data->vertexCount * sizeof(GlhMeshVertex), data->vertices, GL_STATIC_DRAW);
+    if((flags & GLH_MESH_LODS) && data->vertexCount > 0) {
+        uploadMeshLODs(mesh, data->vertices[0].position, sizeof(MeshVertex), data->vertexCount, data->indices, data->indexCount, flags & GLH_MESH_OPTIMIZE);
+    } else {
+        uploadMeshIndices(mesh, data->indices, data->indexCount, data->vertexCount);
+    }
+    setMeshAttributes(mesh);
+}
+
+int GlhLoadMesh(GlhMesh *mesh, char* filename, int flags) {
+    struct MeshData data;
+    size_t length = strlen(filename);
+    bool obj = length >= 4 && strcmp(filename + length - 4, ".obj") == 0;
+    if((obj ? mesh_data_import_obj(&data, filename) : mesh_data_map(&data, filename)) != 0) return -1;
+    if(obj && (flags & GLH_MESH_OPTIMIZE)) {
+        float before, after;
+        mesh_data_optimize(&data, &before, &after);
+        printf("mesh %s: %i triangles, acmr %.3f -> %.3f\n", filename, data.indexCount / 3, before, after);
+    }
+    GlhInitMeshFromData(mesh, &data, flags);
+    mesh_data_free(&data);
+    if(mesh->lodCount > 1) {
+        printf("mesh %s: levels of detail", filename);
+        for(int i = 0; i < mesh->lodCount; i++) printf(" %i", mesh->lods[i].indexCount / 3);
+        printf(" triangles\n");
+    }
+    return 0;
 }
 
 void GlhFreeMesh(GlhMesh *mesh) {
-    vector_free(mesh->verticies);
-    vector_free(mesh->normals);
+    GlhMeshDropCPUData(mesh);
     vector_free(mesh->indexes);
-    vector_free(mesh->texCoords);
+}
+
+void GlhMeshDropCPUData(GlhMesh *mesh) {
+    Vector *vectors[] = {&mesh->verticies, &mesh->normals, &mesh->texCoords};
+    for(int i = 0; i < 3; i++) {
+        vector_free(*vectors[i]);
+        // empty, so freeing again (GlhFreeMesh) or reading the size is still fine
+        vectors[i]->data = NULL;
+        vectors[i]->size = 0;
+        vectors[i]->allocated = 0;
+    }
 }
 
 void GlhInitObject(GlhObject *obj, GLuint texture, vec3 scale, vec3 rotation, vec3 translation, GlhMesh *mesh, GlhProgram *program) {
@@ -552,6 +1805,7 @@ void GlhInitObject(GlhObject *obj, GLuint texture, vec3 scale, vec3 rotation, ve
     glm_vec3_zero(tsfm.transformsOrigin);
     // file GlhObject struct
     obj->type = regular;
+    obj->contextIndex = -1;
     obj->transforms = tsfm;
     obj->mesh = mesh;
     obj->program = program;
@@ -561,57 +1815,18 @@ void GlhInitObject(GlhObject *obj, GLuint texture, vec3 scale, vec3 rotation, ve
 void GlhUpdateObjectModelMatrix(GlhObject *obj) {
     GlhTransformsToMat4(&obj->transforms, &obj->cachedModelMatrix);
 }
-//internal, used to avoid repeating code
-void initArrayBuffer(GLuint *buffer, int components, Vector *vec, char* label) {
-    // create and bind buffer
-    glGenBuffers(1, buffer);
-    set_opengl_label(GL_BUFFER, *buffer, label);
-
-    glBindBuffer(GL_ARRAY_BUFFER, *buffer);
-    // declare the array in which the flattened vector's data will be stored to be passed to the buffer
-    float array[vec->size * components];
-    // flattens the vector (from vec3[x] to float[3 * x] or vec2[x] to flaot[2 * x])
-    for(int i = 0; i < (vec->size) * components; i += components) {
-        if(components == 2) {
-            array[i + 0] = vector_get(vec->data, i / components, vec2)[0];
-            array[i + 1] = vector_get(vec->data, i / components, vec2)[1];
-        } else {
-            array[i + 0] = vector_get(vec->data, i / components, vec3)[0];
-            array[i + 1] = vector_get(vec->data, i / components, vec3)[1];
-            array[i + 2] = vector_get(vec->data, i / components, vec3)[2];
-        }
-    }
-    // fill buffer with data
-    glBufferData(GL_ARRAY_BUFFER, vec->size * components * sizeof(float), array, GL_STATIC_DRAW);
-}
-
-void GlhGenerateMeshBuffers(GlhMesh *mesh) {
-    // prepare data and create, bind and fills buffer with it
-    initArrayBuffer(&mesh->bufferData.vertexBuffer, 3, &mesh->verticies, "BUFFER_VERTICIES");
-    initArrayBuffer(&mesh->bufferData.normalBuffer, 3, &mesh->normals, "BUFFER_NORMALS");
-    initArrayBuffer(&mesh->bufferData.tcoordBuffer, 2, &mesh->texCoords, "BUFFER_TEXCOORDS");
-    // same thing for indices vectors (done like that because the type and buffer type are different (int and GL_ELEMENT_ARRAY here))
-    glGenBuffers(1, &mesh->bufferData.indexsBuffer);
-    set_opengl_label(GL_BUFFER, mesh->bufferData.indexsBuffer, "BUFFER_INDICIES");
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->bufferData.indexsBuffer);
-    int indexes[mesh->indexes.size * 3];
-    // flatten vector
-    for (int i = 0; i < (mesh->indexes.size) * 3; i += 3) {
-        indexes[i + 0] = (int)(vector_get(mesh->indexes.data, i/3, vec3)[0]);
-        indexes[i + 1] = (int)(vector_get(mesh->indexes.data, i/3, vec3)[1]);
-        indexes[i + 2] = (int)(vector_get(mesh->indexes.data, i/3, vec3)[2]);
-    }
-    // fill buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indexes.size * 3 * sizeof(unsigned int), &indexes[0], GL_STATIC_DRAW);
-    // 3 verticies per triangle
-    mesh->bufferData.vertexCount = mesh->indexes.size * 3;
-}
-
 // empty right now because no manually allocated data is directly linked with objects
 // i still recomend calling it when and objects is not needed for later (multiple
 // textures stored in vectors maybe)
 void GlhFreeObject(GlhObject *obj) {}
 
+void GlhInitGroup(GlhGroup *grp, GlhTransforms *tsf) {
+    grp->type = group;
+    grp->contextIndex = -1;
+    grp->transforms = tsf != NULL ? *tsf : GlhGetIdentityTransform();
+    glm_mat4_identity(grp->cachedModelMatrix);
+}
+
 void GlhInitFreeType() {
     if(FT_Init_FreeType(&ft)) {
         printf("ERROR, couldon't init freetype\n");
@@ -623,16 +1838,21 @@ void GlhFreeFreeType() {
 }
  
 void GlhFreeFont(GlhFont *font) {
-    for(int i = 0; i < font->glyphsData.keyVector.size; i++) {
-        free(vector_get(font->glyphsData.keyVector.data, i, char*));
-    }
-    map_free(&font->glyphsData);
-    glDeleteTextures(1, &font->texture);
+    free(font->glyphs.sorted);
+    GlhDeleteTexture(font->texture);
+}
+
+// internal, qsort comparator ordering glyph table entries by codepoint
+int compareGlyphTableEntries(const void* a, const void* b) {
+    unsigned long ca = ((GlhGlyphTableEntry*)a)->codepoint;
+    unsigned long cb = ((GlhGlyphTableEntry*)b)->codepoint;
+    return (ca > cb) - (ca < cb);
 }
 
 void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, float packingPrecision) {
-    // init the final map which will store all the existing glyph data, plus a single default char
-    map_init(&font->glyphsData, sizeof(GlhFontGLyphData));
+    // empty glyph table, so that freeing a font which failed to load is fine
+    font->glyphs.sorted = NULL;
+    font->glyphs.sortedCount = 0;
     // load the font and set char size
     FT_Face face;
     if(FT_New_Face(ft, ttfFileName, 0, &face)) {
@@ -800,6 +2020,11 @@ void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, flo
     font->textureSideLength = sideLength;
     // allocate memory to store the font's atlas' pixels
     char* pixels = (char*)calloc(sideLength * sideLength, 1);
+    // the table which will store all the existing glyph data, the direct part is filled
+    // with the "no glyph" glyph once it has been found (usedDirect tells which ones are real)
+    GlhGlyphTable *table = &font->glyphs;
+    bool usedDirect[GLH_GLYPH_TABLE_DIRECT_SIZE] = {};
+    table->sorted = malloc((_glyphCount + 2) * sizeof(GlhGlyphTableEntry));
     for(int i = 0; i < _glyphCount + 2; i++) {
         // put the char info in the map
         GlhFontGLyphData info = {};
@@ -814,17 +2039,18 @@ void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, flo
         info.x_off = (float) prePackingGlyphsData[i].xo * invSize;
         info.y_off = (float) prePackingGlyphsData[i].yo * invSize;
 
-        // here the malloc is mendatory because only the pointer to the chars is stored in the vectors
-        // but that doesn't prevent from dangeling pointers.
-        // TODO: make a custom String Vector optimized to store strings and prevent dangeling pointers
-        // allocate enough memory to store the ULong char code into a char*
-        // + sizeof(char) for the null termination
-        char* key = malloc(sizeof(unsigned long) + sizeof(char));
-        *(unsigned long*)key = prePackingGlyphsData[i].c; // put the char code in the char*
-        *(sizeof(unsigned long) + key) = '\0'; // null terminate 
-
-        // store all the generated glyph infos in the font map
-        map_set(&font->glyphsData, key, &info);
+        // store all the generated glyph infos in the font's glyph table
+        unsigned long c = prePackingGlyphsData[i].c;
+        if(c == (unsigned long) -1) {
+            table->noGlyph = info;
+        } else if(c < GLH_GLYPH_TABLE_DIRECT_SIZE) {
+            table->direct[c] = info;
+            usedDirect[c] = true;
+        } else {
+            table->sorted[table->sortedCount].codepoint = c;
+            table->sorted[table->sortedCount].data = info;
+            table->sortedCount++;
+        }
 
         // set atlas' pixels to the char's pixels (correctly offseted)
         for(int y = 0; y < prePackingGlyphsData[i].h; y++) {
@@ -839,13 +2065,19 @@ void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, flo
         free(prePackingGlyphsData[i].px);
     }
 
+    // resolve the missing direct glyphs now, so that lookups never have to
+    for(int c = 0; c < GLH_GLYPH_TABLE_DIRECT_SIZE; c++) {
+        if(!usedDirect[c]) table->direct[c] = table->noGlyph;
+    }
+    qsort(table->sorted, table->sortedCount, sizeof(GlhGlyphTableEntry), compareGlyphTableEntries);
+
     FT_Done_Face(face);
 	FT_Done_FreeType(ft);
 
     // create opengl texture
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // to be able to use single channel textures
     glGenTextures(1, &font->texture);
-    glBindTexture(GL_TEXTURE_2D, font->texture);
+    GlhBindTexture(font->texture);
     set_opengl_label(GL_TEXTURE, font->texture, "TEXTURE_FONT_ATLAS");
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -862,59 +2094,71 @@ void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, flo
 	free(pixels);
 }
 
-void _characterToGlyphData(char c, GlhFont *font, GlhFontGLyphData *cdata) {
-    // converting the char to a correctly formated font char info map key
-    // looks complicated but really just is:
-    // make char array, store the un altered unsigned long char code data inside
-    // and null terminate
-    char k[9]; // 9 -> 8 bytes for the unsigned long, + 1 for the nul termination
-    *(unsigned long*)k = (unsigned long) c; // cast the char* to an unsined long pointer, to just set it like that
-    k[8] = '\0'; // null terminate
-    // get the glyph data if it exist, fallback to default if it doesn't
-    if(map_has(&font->glyphsData, k)) {
-        map_get(&font->glyphsData, k, cdata);
-    } else {
-        map_get(&font->glyphsData, fontGlyphDataMapDefaultKey, cdata);
+GlhFontGLyphData* GlhFontGetGlyph(GlhFont *font, unsigned long codepoint) {
+    GlhGlyphTable *table = &font->glyphs;
+    // most text only ever gets here
+    if(codepoint < GLH_GLYPH_TABLE_DIRECT_SIZE) return &table->direct[codepoint];
+    // binary search the rest
+    int lo = 0;
+    int hi = table->sortedCount - 1;
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        unsigned long c = table->sorted[mid].codepoint;
+        if(c == codepoint) return &table->sorted[mid].data;
+        if(c < codepoint) lo = mid + 1;
+        else hi = mid - 1;
     }
+    return &table->noGlyph;
+}
+
+GlhFontGLyphData* _characterToGlyphData(char c, GlhFont *font) {
+    // through unsigned char so that bytes >= 128 are read as Latin-1 codepoints instead of sign extended garbage
+    return GlhFontGetGlyph(font, (unsigned char) c);
 }
 
 float GlhFontGetTextWidth(GlhFont *font, char* text) {
     int len = strlen(text);
     float width = 0;
     for(int i = 0; i < len; i++) {
-        GlhFontGLyphData cdata;
-        _characterToGlyphData(text[i], font, &cdata);
-        width += cdata.advance;
+        width += _characterToGlyphData(text[i], font)->advance;
     }
     return width;
 }
 
 void _characterToMesh(char c, GlhFont *font, float *xoff, float yoff, float *newVerticies, float *newTexCoords, int arrOffset) {
-    GlhFontGLyphData cdata;
-    _characterToGlyphData(c, font, &cdata);
+    GlhFontGLyphData *cdata = _characterToGlyphData(c, font);
     // to convert from 0 -> textureSideLength texCoords to 0 -> 1
     float invsl = 1.0 / font->textureSideLength;
-    float xoffset = *xoff + cdata.x_off;
-    float yoffset = yoff + cdata.y_off - cdata.hgl;
+    float xoffset = *xoff + cdata->x_off;
+    float yoffset = yoff + cdata->y_off - cdata->hgl;
     int ao = arrOffset * 3 * 4;
     // simple but not horrible way to set the new verticies
-    newVerticies[ao + 0] =       xoffset;       newVerticies[ao +  1] =       yoffset;       newVerticies[ao +  2] = 0;
-    newVerticies[ao + 3] = xoffset + cdata.wgl; newVerticies[ao +  4] =       yoffset;       newVerticies[ao +  5] = 0;
-    newVerticies[ao + 6] =       xoffset;       newVerticies[ao +  7] = yoffset + cdata.hgl; newVerticies[ao +  8] = 0;
-    newVerticies[ao + 9] = xoffset + cdata.wgl; newVerticies[ao + 10] = yoffset + cdata.hgl; newVerticies[ao + 11] = 0;
+    newVerticies[ao + 0] =        xoffset;        newVerticies[ao +  1] =        yoffset;        newVerticies[ao +  2] = 0;
+    newVerticies[ao + 3] = xoffset + cdata->wgl; newVerticies[ao +  4] =        yoffset;        newVerticies[ao +  5] = 0;
+    newVerticies[ao + 6] =        xoffset;        newVerticies[ao +  7] = yoffset + cdata->hgl; newVerticies[ao +  8] = 0;
+    newVerticies[ao + 9] = xoffset + cdata->wgl; newVerticies[ao + 10] = yoffset + cdata->hgl; newVerticies[ao + 11] = 0;
     ao = arrOffset * 2 * 4;
-    newTexCoords[ao + 0] = ((float)cdata.x0) * invsl; newTexCoords[ao + 1] = ((float)cdata.y0) * invsl;
-    newTexCoords[ao + 2] = ((float)cdata.x1) * invsl; newTexCoords[ao + 3] = ((float)cdata.y0) * invsl;
-    newTexCoords[ao + 4] = ((float)cdata.x0) * invsl; newTexCoords[ao + 5] = ((float)cdata.y1) * invsl;
-    newTexCoords[ao + 6] = ((float)cdata.x1) * invsl; newTexCoords[ao + 7] = ((float)cdata.y1) * invsl;
-    *xoff += cdata.advance;
+    newTexCoords[ao + 0] = ((float)cdata->x0) * invsl; newTexCoords[ao + 1] = ((float)cdata->y0) * invsl;
+    newTexCoords[ao + 2] = ((float)cdata->x1) * invsl; newTexCoords[ao + 3] = ((float)cdata->y0) * invsl;
+    newTexCoords[ao + 4] = ((float)cdata->x0) * invsl; newTexCoords[ao + 5] = ((float)cdata->y1) * invsl;
+    newTexCoords[ao + 6] = ((float)cdata->x1) * invsl; newTexCoords[ao + 7] = ((float)cdata->y1) * invsl;
+    *xoff += cdata->advance;
 }
 
 void GlhApplyTransformsToBoundingBox(GlhBoundingBox *box, GlhTransforms transforms) {
     mat4 mat;
     GlhTransformsToMat4(&transforms, &mat);
-    glm_mat4_mulv3(mat, box->start, 1.0, box->start);
-    glm_mat4_mulv3(mat, box->end, 1.0, box->end);
+    GlhTransformBoundingBox(box, mat);
+}
+
+void GlhTransformBoundingBox(GlhBoundingBox *box, mat4 model) {
+    // transforming only start and end would be wrong as soon as there is a rotation
+    BvhBox local, world;
+    glm_vec3_copy(box->start, local.min);
+    glm_vec3_copy(box->end, local.max);
+    bvh_box_transform(&local, (float*) model, &world);
+    glm_vec3_copy(world.min, box->start);
+    glm_vec3_copy(world.max, box->end);
 }
 
 GlhBoundingBox GlhTextObjectGetBoundingBox(GlhTextObject *tob, float margin) {
@@ -922,9 +2166,9 @@ GlhBoundingBox GlhTextObjectGetBoundingBox(GlhTextObject *tob, float margin) {
     vec3 max = {INT_MIN, INT_MIN, INT_MIN};
     for(int i = 0; i < tob->verticies.size; i+=3) {
         vec3 vert;
-        vert[0] = vector_get(tob->verticies.data, i + 0, float);
-        vert[1] = vector_get(tob->verticies.data, i + 1, float);
-        vert[2] = vector_get(tob->verticies.data, i + 2, float);
+        vert[0] = vector_float_get(&tob->verticies, i + 0);
+        vert[1] = vector_float_get(&tob->verticies, i + 1);
+        vert[2] = vector_float_get(&tob->verticies, i + 2);
 
         min[0] = vert[0] < min[0] ? vert[0] : min[0];
         min[1] = vert[1] < min[1] ? vert[1] : min[1];
@@ -961,8 +2205,8 @@ void GlhTextObjectUpdateMesh(GlhTextObject *tob, char* OldString) {
     }
     changedLength = newLength - charOff;
     // remove the changed glyphs' verticies and texcoords
-    vector_splice(&tob->verticies, charOff * 3 * 4, -1, NULL);
-    vector_splice(&tob->texCoords, charOff * 2 * 4, -1, NULL);
+    vector_float_splice(&tob->verticies, charOff * 3 * 4, -1);
+    vector_float_splice(&tob->texCoords, charOff * 2 * 4, -1);
     // recompute the new ones
     float newVerticies[changedLength * 3 * 4];
     float newTexCoords[changedLength * 2 * 4];
@@ -971,67 +2215,75 @@ void GlhTextObjectUpdateMesh(GlhTextObject *tob, char* OldString) {
     // if we reuse data
     if (tob->verticies.size > 0 && charOff > 0) {
         // get the advance of the last reused glyph
-        GlhFontGLyphData cd;
-        _characterToGlyphData(tob->_text[charOff-1], tob->font, &cd);
+        GlhFontGLyphData *cd = _characterToGlyphData(tob->_text[charOff-1], tob->font);
         // and add it to its x pos into the xoffset
-        xoff = vector_get(tob->verticies.data, tob->verticies.size - 6, float) + cd.advance;
+        xoff = vector_float_get(&tob->verticies, tob->verticies.size - 6) + cd->advance;
     }
     for(int i = 0; i < changedLength; i++) {
         _characterToMesh(tob->_text[charOff + i], tob->font, &xoff, 0, newVerticies, newTexCoords, i);
     }
     // appends changes to verticies and texcoords vector
-    vector_push_array(&tob->verticies, newVerticies, changedLength * 3 * 4);
-    vector_push_array(&tob->texCoords, newTexCoords, changedLength * 2 * 4);
-    // define normalsPattern, to repeat it in the normals arr (because every verticies will have the same normals)
-    float normalsPattern[3] = {0.0, 0.0, -1.0};
-    float normalsArr[newLength * 3 * 4];
-    float colorsArr[newLength * 4 * 4];
-    memset_pattern(normalsArr, sizeof(normalsArr), normalsPattern, sizeof(normalsPattern));
-    memset_pattern(colorsArr, sizeof(colorsArr), tob->color, sizeof(float) * 4);
-    // compute indices, will allways follow 0, 1, 2, 1, 3, 2 (then 4, 5, 6, 5, 7, 6)
-    int indiciesArr[newLength * 6]; // six for two triangles
-    int vi = 0; // vertex index
-    for(int i = 0; i < newLength * 6; i+=6) {
-        indiciesArr[i + 0] = vi + 0; indiciesArr[i + 1] = vi + 1; indiciesArr[i + 2] = vi + 2;
-        indiciesArr[i + 3] = vi + 1; indiciesArr[i + 4] = vi + 3; indiciesArr[i + 5] = vi + 2;
-        vi += 4;
-    }
-    // put that data in buffers
-    // TODO work in there to cache those buffers and use glBufferSub data if possible for better performances
+    vector_float_push_array(&tob->verticies, newVerticies, changedLength * 3 * 4);
+    vector_float_push_array(&tob->texCoords, newTexCoords, changedLength * 2 * 4);
     // bind VAO now as binding a GL_ELEMENT_ARRAY buffer while the VAO is bound will link it to the VAO
-    glBindVertexArray(tob->bufferData.VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.normalBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(normalsArr), normalsArr, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.colorsBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof( colorsArr), colorsArr, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tob->bufferData.indexsBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indiciesArr), indiciesArr, GL_DYNAMIC_DRAW);
-    // put data in buffers, using glBufferSubData if possible (= if no realloc needed)
-    if(oldLength != newLength || OldString == NULL) {
+    GlhBindVertexArray(tob->bufferData.VAO);
+    if(newLength > tob->glyphCapacity) {
+        // reallocate with room to spare, so that typing doesn't reallocate the driver storage every character
+        int capacity = tob->glyphCapacity > 0 ? tob->glyphCapacity : 16;
+        while(capacity < newLength) capacity *= 2;
+        // normals, colors and indices only depend on the number of glyphs, so they are filled for the
+        // whole capacity once and never touched again until the next reallocation
+        float normalsPattern[3] = {0.0, 0.0, -1.0};
+        float *normalsArr = malloc(capacity * 3 * 4 * sizeof(float));
+        float *colorsArr = malloc(capacity * 4 * 4 * sizeof(float));
+        memset_pattern(normalsArr, capacity * 3 * 4 * sizeof(float), normalsPattern, sizeof(normalsPattern));
+        memset_pattern(colorsArr, capacity * 4 * 4 * sizeof(float), tob->color, sizeof(float) * 4);
+        // compute indices, will allways follow 0, 1, 2, 1, 3, 2 (then 4, 5, 6, 5, 7, 6)
+        int *indiciesArr = malloc(capacity * 6 * sizeof(int)); // six for two triangles
+        int vi = 0; // vertex index
+        for(int i = 0; i < capacity * 6; i+=6) {
+            indiciesArr[i + 0] = vi + 0; indiciesArr[i + 1] = vi + 1; indiciesArr[i + 2] = vi + 2;
+            indiciesArr[i + 3] = vi + 1; indiciesArr[i + 4] = vi + 3; indiciesArr[i + 5] = vi + 2;
+            vi += 4;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.normalBuffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 3 * 4 * sizeof(float), normalsArr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.colorsBuffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 4 * 4 * sizeof(float), colorsArr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tob->bufferData.indexsBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * 6 * sizeof(int), indiciesArr, GL_STATIC_DRAW);
+        free(normalsArr);
+        free(colorsArr);
+        free(indiciesArr);
         glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.vertexBuffer);
-        glBufferData(GL_ARRAY_BUFFER, tob->verticies.size * tob->verticies.data_size, tob->verticies.data, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 3 * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, tob->verticies.size * sizeof(float), tob->verticies.data);
         glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.tcoordBuffer);
-        glBufferData(GL_ARRAY_BUFFER, tob->texCoords.size * tob->texCoords.data_size, tob->texCoords.data, GL_DYNAMIC_DRAW);
-    } else {
+        glBufferData(GL_ARRAY_BUFFER, capacity * 2 * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, tob->texCoords.size * sizeof(float), tob->texCoords.data);
+        tob->glyphCapacity = capacity;
+        // bind attributes to VAO
+        setAttribute(tob->bufferData.vertexBuffer, 0, 3);
+        setAttribute(tob->bufferData.tcoordBuffer, 1, 2);
+        setAttribute(tob->bufferData.normalBuffer, 2, 3);
+        setAttribute(tob->bufferData.colorsBuffer, 3, 4);
+    } else if(changedLength > 0) {
+        // it fits, only the glyphs from the first changed one are sent
         glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.vertexBuffer);
         glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * charOff * 3 * 4, sizeof(newVerticies), newVerticies);
         glBindBuffer(GL_ARRAY_BUFFER, tob->bufferData.tcoordBuffer);
         glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * charOff * 2 * 4, sizeof(newTexCoords), newTexCoords);
     }
-    // bind attributes to VAO
-    setAttribute(tob->bufferData.vertexBuffer, 0, 3);
-    setAttribute(tob->bufferData.tcoordBuffer, 1, 2);
-    setAttribute(tob->bufferData.normalBuffer, 2, 3);
-    setAttribute(tob->bufferData.colorsBuffer, 3, 4);
     // "vertex" here as the number drawn, not the actual one (time 6 for two triangles per quad)
     tob->bufferData.vertexCount = newLength * 6;
-    float max_y = vector_get(tob->verticies.data, tob->verticies.size -2, float);
-    float max_x = vector_get(tob->verticies.data, tob->verticies.size -3, float);
+    float max_y = vector_float_get(&tob->verticies, tob->verticies.size -2);
+    float max_x = vector_float_get(&tob->verticies, tob->verticies.size -3);
 
     tob->transforms.transformsOrigin[0] = max_x * 0.5;
     tob->transforms.transformsOrigin[1] = max_y * 0.5;
 
     GlhBoundingBox boundingBox = GlhTextObjectGetBoundingBox(tob, 0.2);
+    tob->backgroundBox = boundingBox;
 
     float backgroundVerts[] = {
         boundingBox.start[0], boundingBox.start[1], 0,
@@ -1045,7 +2297,7 @@ void GlhTextObjectUpdateMesh(GlhTextObject *tob, char* OldString) {
         tob->backgroundColor[0], tob->backgroundColor[1], tob->backgroundColor[2], tob->backgroundColor[3],
         tob->backgroundColor[0], tob->backgroundColor[1], tob->backgroundColor[2], tob->backgroundColor[3],
     };
-    glBindVertexArray(tob->backgroundQuadBufferData.VAO);
+    GlhBindVertexArray(tob->backgroundQuadBufferData.VAO);
     glBindBuffer(GL_ARRAY_BUFFER, tob->backgroundQuadBufferData.vertexBuffer);
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(backgroundVerts), backgroundVerts);
     glBindBuffer(GL_ARRAY_BUFFER, tob->backgroundQuadBufferData.colorsBuffer);
@@ -1074,6 +2326,7 @@ char* GlhTextObjectGetText(GlhTextObject *tob) {
 // transforms can be NULL
 void GlhInitTextObject(GlhTextObject *tob, char* string, GlhFont *font, vec4 color, vec4 backgroundColor, GlhTransforms *tsf) {
     tob->type = text;
+    tob->contextIndex = -1;
     tob->font = font;
     tob->glyphProgram = &GlobalShaders.glyphs;
     tob->textProgram = &GlobalShaders.text;
@@ -1085,13 +2338,14 @@ void GlhInitTextObject(GlhTextObject *tob, char* string, GlhFont *font, vec4 col
         glm_vec3_copy(GLM_VEC3_ONE, tob->transforms.scale);
         glm_vec3_zero(tob->transforms.transformsOrigin);
     }
-    vector_init(&tob->verticies, 60, sizeof(float));
-    vector_init(&tob->texCoords, 40, sizeof(float));
+    vector_float_init(&tob->verticies, 60);
+    vector_float_init(&tob->texCoords, 40);
 
     glm_vec4_copy(color, tob->color);
     glm_vec4_copy(backgroundColor, tob->backgroundColor);
     tob->_text = malloc(tob->_textAllocated = strlen(string) + 1);
     tob->_text[0] = '\0';
+    tob->glyphCapacity = 0;
     glGenVertexArrays(1, &tob->bufferData.VAO);
     glGenBuffers(1, &tob->bufferData.vertexBuffer);
     glGenBuffers(1, &tob->bufferData.tcoordBuffer);
@@ -1123,7 +2377,7 @@ void GlhInitTextObject(GlhTextObject *tob, char* string, GlhFont *font, vec4 col
     float normals[12] = {0, 0, -1.0, 0, 0, -1.0, 0, 0, -1.0, 0, 0, -1.0};
     int indexes[6] = {0, 1, 2, 1, 3, 2};
 
-    glBindVertexArray(tob->backgroundQuadBufferData.VAO);
+    GlhBindVertexArray(tob->backgroundQuadBufferData.VAO);
     glBindBuffer(GL_ARRAY_BUFFER, tob->backgroundQuadBufferData.vertexBuffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(tmpVerts), tmpVerts, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, tob->backgroundQuadBufferData.normalBuffer);
@@ -1144,25 +2398,24 @@ void GlhInitTextObject(GlhTextObject *tob, char* string, GlhFont *font, vec4 col
 }
 
 void GlhFreeTextObject(GlhTextObject *tob) {
-    vector_free(tob->verticies);
-    vector_free(tob->texCoords);
+    vector_float_free(tob->verticies);
+    vector_float_free(tob->texCoords);
     free(tob->_text);
 }
 
 void GlhInitComputeShader(GlhComputeShader *cs, char* filename) {
-    GLuint shader;
-    loadShader(filename, GL_COMPUTE_SHADER, &shader);
-    cs->program = glCreateProgram();
-    set_opengl_label(GL_PROGRAM, cs->program, "SHADER_PROGRAM_COMPUTE");
-    glAttachShader(cs->program, shader);
-    glLinkProgram(cs->program);
+    GLenum types[] = {GL_COMPUTE_SHADER};
+    char* filenames[] = {filename};
+    cs->program = buildProgram(types, filenames, 1, NULL, 0);
 }
 
 void GlhRunComputeShader(GlhComputeShader *cs, GLuint inputTexture, GLuint outputTexture, GLenum sizedInFormat, GLenum sizedOutFormat, int workGroupsWidth, int workGroupsHeight) {
-    glUseProgram(cs->program);
+    // waits for the compilation the first time
+    finishCompiledProgram(cs->program);
+    GlhUseProgram(cs->program);
     glBindImageTexture(1, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, sizedOutFormat);
     glBindImageTexture(0, inputTexture, 0, GL_FALSE, 0, GL_READ_ONLY, sizedInFormat);
-    glBindTexture(GL_TEXTURE_2D, inputTexture);
+    GlhBindTexture(inputTexture);
     glDispatchCompute(workGroupsWidth, workGroupsHeight, 1);
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
@@ -1170,7 +2423,7 @@ void GlhRunComputeShader(GlhComputeShader *cs, GLuint inputTexture, GLuint outpu
 int loadTexture(GLuint *texture, char* filename, bool alpha, GLenum interpolation) {
     // create, bind texture and set parameters
     glGenTextures(1, texture);
-    glBindTexture(GL_TEXTURE_2D, *texture);
+    GlhBindTexture(*texture);
     set_opengl_label(GL_TEXTURE, *texture, "TEXTURE");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -1199,7 +2452,7 @@ int loadTexture(GLuint *texture, char* filename, bool alpha, GLenum interpolatio
 
 void createSingleColorTexture(GLuint *texture, float r, float g, float b) {
     glGenTextures(1, texture);
-    glBindTexture(GL_TEXTURE_2D, *texture);
+    GlhBindTexture(*texture);
     set_opengl_label(GL_TEXTURE, *texture, "TEXTURE_SINGLE_COLOR");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -1229,7 +2482,7 @@ void saveImage(char* filepath, GLFWwindow* w) {
 }
 void createEmptySizedTexture(GLuint *texture, int width, int height, GLenum sizedFormat, GLenum format, GLenum type) {
     glGenTextures(1, texture);
-    glBindTexture(GL_TEXTURE_2D, *texture);
+    GlhBindTexture(*texture);
     set_opengl_label(GL_TEXTURE, *texture, "TEXTURE_BLANK");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -6,10 +6,46 @@
 #include <GLFW/glfw3.h>
 #include "vector.h"
 #include "maps.h"
+#include "stack.h"
+#include "transforms.h"
+#include "bvh.h"
+#include "meshes.h"
+#include "shadercache.h"
+
+// directory program binaries are cached in by default (relative to the working directory)
+#define GLH_PROGRAM_CACHE_DIRECTORY "shader_cache"
+
+// number of texture units mirrored by the state cache
+#define GLH_STATE_TEXTURE_UNITS 16
+// value of a mirrored binding that isn't known (never equal to a real name)
+#define GLH_UNKNOWN_BINDING ((GLuint) -1)
+
+// CPU side mirror of the GL state glhelper touches. every bind / enable done through the
+// Glh* state functions below is filtered against it, so redundant calls never reach the
+// driver and the current state can be read without glGet round trips.
+//! any GL call changing one of those outside of the state functions makes the mirror wrong,
+//! call GlhInvalidateStateCache after such code
+typedef struct {
+    GLuint program;
+    GLuint VAO;
+    GLuint framebuffer;
+    int activeTextureUnit;
+    GLuint textures[GLH_STATE_TEXTURE_UNITS];
+    GLfloat clearColor[4];
+    // 1, 0, or -1 when unknown
+    int blend;
+    GLenum blendSrc;
+    GLenum blendDst;
+    // same as blend
+    int depthTest;
+    GLenum depthFunc;
+} GlhGLState;
 
 // do it in advance because circular dependency
 typedef struct GlhContext GlhContext;
 
+VECTOR_DECLARE(GLint)
+
 //? should scale be a camera property ?, like a bigger camera displaying thing smaller
 // in that case GlhCamera should just include a GlhTransform property
 typedef struct {
@@ -19,8 +55,30 @@ typedef struct {
     float fov;
     float zNear;
     float zFar;
+    // set when the transforms (view) or the specifics / window size (projection) changed,
+    // GlhUpdateContextMatrices only recomputes what is dirty
+    bool viewDirty;
+    bool projectionDirty;
 } GlhCamera;
 
+// binding point of the camera uniform block, every GlhProgram declaring a `GlhCamera` block gets it bound there
+#define GLH_CAMERA_BLOCK_BINDING 0
+
+// CPU side of the std140 `GlhCamera` uniform block, uploaded once per frame when the camera changed:
+// layout(std140) uniform GlhCamera {
+//     mat4 view;
+//     mat4 projection;
+//     mat4 viewProjection;
+//     vec4 cameraPosition;
+// };
+// every member is a multiple of 16 bytes so the C layout matches std140 as is
+typedef struct {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} GlhCameraBlock;
+
 typedef struct {
     vec3 scale;
     vec3 translation;
@@ -36,39 +94,87 @@ typedef struct {
     GLuint colorsBuffer;
     GLuint VAO;
     int vertexCount;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT for meshes, text objects always use GL_UNSIGNED_INT
+    GLenum indexType;
 } GlhMeshBufferData;
 
 typedef struct {
+    vec3 start;
+    vec3 end;
+} GlhBoundingBox;
+
+// levels of detail a mesh can have, the full mesh included
+#define GLH_MAX_LODS 5
+// a level is drawn once its error, projected on the screen, is under this many pixels
+#define GLH_LOD_PIXEL_ERROR 1.0f
+
+// one level of detail of a mesh, a range of its index buffer (every level uses the same vertices)
+typedef struct {
+    // first index of the level in the index buffer
+    int indexOffset;
+    int indexCount;
+    // how far (in local units) the surface may be from the full mesh's
+    float error;
+} GlhMeshLOD;
+
+// one vertex of the interleaved buffer of a mesh, the layout of mesh files (see meshes.h)
+typedef MeshVertex GlhMeshVertex;
+
+typedef struct {
+    // a mesh only uses vertexBuffer (interleaved GlhMeshVertex) and indexsBuffer
     GlhMeshBufferData bufferData;
+    // local space box of the verticies, computed once by GlhInitMesh
+    GlhBoundingBox bounds;
+    // lods[0] is the full mesh (bufferData.vertexCount indices from the start), the others are
+    // simplified from it, each coarser than the previous one. only 1 unless the mesh was loaded with GLH_MESH_LODS
+    GlhMeshLOD lods[GLH_MAX_LODS];
+    int lodCount;
     Vector verticies;
     Vector normals;
+    // triangles, 3 unsigned ints each
     Vector indexes;
     Vector texCoords;
 } GlhMesh;
 
 typedef struct {
-    Vector uniforms;
-    Vector uniformsLocation;
-    Vector attributes;
+    SmallVector uniforms;
+    Vector_GLint uniformsLocation;
+    // set when the vertex shader has a `mat4 iModel` input. objects using an instanced program and sharing
+    // a mesh and texture are drawn in a single instanced draw call, iModel being their model matrix.
+    // setGlobalUniforms is then called once per draw (with the first object), so it must only set per
+    // program uniforms
+    bool instanced;
+    // set from GlhInitProgram until GlhFinishProgram, the program may still be compiling on the driver's threads
+    // and instanced, uniformsLocation and uniformsByName aren't known yet
+    bool pending;
+    // uniform name to location, frozen as it never changes after GlhFinishProgram
+    FrozenMap uniformsByName;
+    SmallVector attributes;
     GLuint shaderProgram; 
     // a function pointer for a function setting the uniforms to their correct values.
     // it is not directly implemented in the helper as no shaders are provided by default
-    // and as such should be dealt with by the user
+    // and as such should be dealt with by the user. the camera matrices come from the GlhCamera
+    // uniform block, so it can be NULL if the program has no other uniform to set
     void (*setGlobalUniforms)(void*, GlhContext *);
 } GlhProgram;
 
 typedef enum {
     regular,
-    text
+    text,
+    group
 } GlhObjectTypes;
 
 typedef struct {
     GlhObjectTypes type;
+    // index in the context's children and transform store, -1 until appended to a context
+    int contextIndex;
 } GlhAbstractElement;
 
 // here type must be the first member, to allow to check type before knowing what struct it is
+// (and contextIndex the second one)
 typedef struct {
     GlhObjectTypes type;
+    int contextIndex;
     GlhTransforms transforms;
     // reference here, to be able to use the same mesh on multiple objects
     GlhMesh *mesh;
@@ -78,14 +184,46 @@ typedef struct {
     GLuint texture;
 } GlhObject;
 
+typedef struct {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+    float wgl;
+    float hgl;
+    float x_off;
+    float y_off;
+    float advance;
+} GlhFontGLyphData;
+
+// number of codepoints (ASCII and Latin-1) stored in a flat array indexed by the codepoint itself
+#define GLH_GLYPH_TABLE_DIRECT_SIZE 256
+
+typedef struct {
+    unsigned long codepoint;
+    GlhFontGLyphData data;
+} GlhGlyphTableEntry;
+
+// codepoint to glyph data lookup of a font, built once by GlhInitFont
+typedef struct {
+    // codepoints missing from the font hold a copy of noGlyph, so these never need a check
+    GlhFontGLyphData direct[GLH_GLYPH_TABLE_DIRECT_SIZE];
+    // every glyph with a codepoint >= GLH_GLYPH_TABLE_DIRECT_SIZE, sorted by codepoint
+    GlhGlyphTableEntry* sorted;
+    int sortedCount;
+    // the "no glyph" glyph, returned for codepoints the font doesn't have
+    GlhFontGLyphData noGlyph;
+} GlhGlyphTable;
+
 typedef struct {
     GLuint texture;
     int textureSideLength;
-    Map glyphsData;
+    GlhGlyphTable glyphs;
 } GlhFont;
 
 typedef struct {
     GlhObjectTypes type;
+    int contextIndex;
     GlhFont *font;
     GlhProgram *glyphProgram;
     GlhProgram *textProgram;
@@ -97,32 +235,31 @@ typedef struct {
     mat4 cachedModelMatrix;
     vec4 color;
     vec4 backgroundColor;
-    Vector verticies;
-    Vector texCoords;
+    // local space area covered by the background, updated with the mesh
+    GlhBoundingBox backgroundBox;
+    // number of glyphs the buffers have room for, they are only reallocated when the text outgrows it
+    int glyphCapacity;
+    Vector_float verticies;
+    Vector_float texCoords;
 } GlhTextObject;
 
+// an element that isn't drawn, only there to move its children together (a menu for example)
+typedef struct {
+    GlhObjectTypes type;
+    int contextIndex;
+    GlhTransforms transforms;
+    mat4 cachedModelMatrix;
+} GlhGroup;
+
 typedef union {
     GlhAbstractElement any;
     GlhObject regular;
     GlhTextObject text;
+    GlhGroup group;
 } GlhElement;
 
-typedef struct {
-    int x0;
-    int y0;
-    int x1;
-    int y1;
-    float wgl;
-    float hgl;
-    float x_off;
-    float y_off;
-    float advance;
-} GlhFontGLyphData;
-
-typedef struct {
-    vec3 start;
-    vec3 end;
-} GlhBoundingBox;
+typedef GlhElement* GlhElementPtr;
+VECTOR_DECLARE(GlhElementPtr)
 
 typedef enum {
     FBSizedTexture
@@ -132,28 +269,147 @@ typedef struct {
     GLuint FBO;
     GLuint attachments[2];
     bool active;
+    // false once deleted, its slot (and id) will be reused by the next created FBO
+    bool alive;
     GlhFBOType type;
+    // stable handle, index in the provider's FBOs, never changes during the FBO's lifetime
     unsigned long id;
+    // size and format of the attachments, known at creation so nothing needs to query GL
+    int width;
+    int height;
+    GLenum format;
+    // provider generation at creation, FBOs of an older generation are deleted on release
+    unsigned int generation;
 } GlhFBO;
 
+// inactive FBOs sharing a type, size and format, ready to be handed out
 typedef struct {
+    GlhFBOType type;
+    int width;
+    int height;
+    GLenum format;
+    Vector_int freeIds;
+} GlhFBOPool;
+
+// seconds the framebuffer size must stay the same before window sized FBOs are recreated,
+// so dragging the window edge doesn't reallocate them every frame
+#define GLH_FBO_RESIZE_DEBOUNCE 0.2
+
+typedef struct {
+    // every FBO by id, deleted slots are reused but never moved
     Vector FBOs;
+    Vector_int freeSlots;
+    // one pool per (type, size, format), there are only ever a handful
+    Vector pools;
     GlhContext *ctx;
+    // size window sized FBOs are created with, only changes once a resize settled
+    int width;
+    int height;
+    bool resizePending;
+    int pendingWidth;
+    int pendingHeight;
+    double resizeTime;
+    // bumped every time the window sized FBOs are invalidated
+    unsigned int generation;
 } GlhFBOProvider;
 
+typedef struct {
+    // program, texture, VAO and depth packed so that sorting on it groups draws sharing state
+    unsigned long key;
+    GlhElement *element;
+    // level of detail a regular object is drawn with
+    int lod;
+} GlhRenderQueueItem;
+
+VECTOR_DECLARE(GlhRenderQueueItem)
+
+// rebuilt every frame by GlhRenderContext
+typedef struct {
+    Vector_GlhRenderQueueItem items;
+    // scratch space for the radix sort
+    Vector_GlhRenderQueueItem sortBuffer;
+} GlhRenderQueue;
+
+// consecutive text objects of a frame (in back to front order) using the same font are drawn by GlhRenderContext
+// in a single draw call, straight into the current framebuffer: their backgrounds and glyphs are transformed
+// on the CPU and written straight into the context's stream buffer
+typedef struct {
+    // reads position (3), color (4), texCoord (2) per vertex, 4 vertices per quad, from its binding 0
+    GLuint VAO;
+    GLuint indexBuffer;
+    // number of quads the index buffer has indices for (they are always the same pattern)
+    int quadCapacity;
+    // text objects of the current frame, in drawing order
+    Vector_GlhElementPtr texts;
+} GlhTextBatch;
+
+// regions of a stream buffer, the CPU writes one while the GPU may still be reading the others
+#define GLH_STREAM_REGIONS 3
+// starting size of a region, doubled until it fits if a single allocation is bigger
+#define GLH_STREAM_REGION_SIZE (1 << 20)
+
+// persistently mapped buffer the per frame data (instance matrices, batched text) is written straight into,
+// without any driver side copy or reallocation. it is split in GLH_STREAM_REGIONS regions used one after the
+// other, each one fenced when left, so a region is only written again once the GPU is done reading it
+typedef struct {
+    GLuint buffer;
+    // the whole buffer, mapped for as long as it lives (coherent, writes don't need to be flushed)
+    char* mapped;
+    GLsizeiptr regionSize;
+    // region being written and where the next allocation starts in it
+    int region;
+    GLsizeiptr offset;
+    // pending fence of every region, 0 if there isn't any
+    GLsync fences[GLH_STREAM_REGIONS];
+} GlhStreamBuffer;
+
+// what the last GlhRenderContext sent to the driver, to see what sorting saves
+typedef struct {
+    int drawCalls;
+    // objects drawn through instanced draw calls
+    int instances;
+    // objects skipped because they were outside of the camera frustum
+    int culled;
+    int programBinds;
+    int textureBinds;
+    int VAOBinds;
+    // of the objects drawn, at the level of detail they were drawn with
+    int triangles;
+} GlhRenderStats;
+
 //! as of now, applications should only have a single context, and would probably break otherwise
 struct GlhContext{
     GLFWwindow *window;
     GlhCamera camera;
     mat4 cachedViewMatrix;
     mat4 cachedProjectionMatrix;
-    Vector children;
+    // projection * view, updated with the children's transforms
+    mat4 cachedViewProjectionMatrix;
+    // pixels a local unit covers on screen at a distance of 1 (perspective) or anywhere (orthographic),
+    // computed with the projection, to pick levels of detail
+    float lodPixelScale;
+    // uniform buffer of the GlhCamera block, bound at GLH_CAMERA_BLOCK_BINDING
+    GLuint cameraBuffer;
+    Vector_GlhElementPtr children;
+    // transforms of the children (same indices), their model matrices are only recomputed when they change.
+    // children are kept depth first, every element being directly followed by its own children
+    struct TransformStore transforms;
+    // world space boxes of the drawable children (same indices), tested against the frustum every frame
+    struct Bvh bvh;
+    // children indices that passed the frustum test this frame
+    Vector_int visible;
     GlhFBOProvider FBOProvider;
+    GlhRenderQueue renderQueue;
+    GlhTextBatch textBatch;
+    // per frame vertex data, moved to its next region at the end of every GlhRenderContext
+    GlhStreamBuffer stream;
+    GlhRenderStats renderStats;
 };
 
 typedef struct {
     GlhProgram glyphs;
     GlhProgram text;
+    GlhProgram batchedText;
 } GlhGlobalShaders;
 
 // ^([a-z]+) ([a-zA-Z]+) \{((?:\n[^}]+)+)\};
@@ -162,29 +418,120 @@ typedef struct {
     GLuint program;
 } GlhComputeShader;
 
+// state cache, the bind / set functions return whether a GL call was actually made
+bool GlhUseProgram(GLuint program);
+bool GlhBindVertexArray(GLuint VAO);
+bool GlhBindFramebuffer(GLuint framebuffer);
+bool GlhActiveTexture(int unit);
+// binds to GL_TEXTURE_2D of the active texture unit
+bool GlhBindTexture(GLuint texture);
+// delete through those so that the mirror doesn't keep the name bound (GL reuses deleted names)
+void GlhDeleteTexture(GLuint texture);
+void GlhDeleteFramebuffer(GLuint framebuffer);
+bool GlhClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+bool GlhSetBlend(bool enabled);
+bool GlhBlendFunc(GLenum src, GLenum dst);
+bool GlhSetDepthTest(bool enabled);
+bool GlhDepthFunc(GLenum func);
+// the mirrored state, to read instead of glGet*
+const GlhGLState* GlhGetState();
+// save the current state, GlhPopState restores it (only sending what changed in between)
+void GlhPushState();
+void GlhPopState();
+// set the mirror to the GL defaults, for a freshly created context (called by GlhInitContext)
+void GlhResetStateCache();
+// forget everything, the next call of every state function reaches the driver
+void GlhInvalidateStateCache();
+// read the shaders and submit them for compilation and linking (or load their binary from the program cache, see
+// GlhSetProgramCacheDirectory) without waiting for the driver: with GL_KHR_parallel_shader_compile every program
+// initialized up front compiles at the same time, on the driver's threads. the program is pending until
+// GlhFinishProgram, which rendering calls for the programs it draws with, so only those can stall a frame.
+// if a file can't be read an error is printed and shaderProgram is 0. every uniform location of a program that
+// couldn't be built or failed to link is -1
 void GlhInitProgram(GlhProgram *prg, char* fragSourceFilename, char* vertSourceFilename, char* uniforms[], int uniformsCount, void (*setUniforms)());
+// GlhInitProgram with a `#define` line for every defines (like "SHADOWS" or "LIGHTS 4") added to both shaders after
+// their #version line. every permutation of the same files is a program of its own, built once per run (programs
+// asking for the same one share the same GL program) and cached like any other
+void GlhInitProgramVariant(GlhProgram *prg, char* fragSourceFilename, char* vertSourceFilename, char* defines[], int definesCount, char* uniforms[], int uniformsCount, void (*setUniforms)());
+// programs are cached in directory (GLH_PROGRAM_CACHE_DIRECTORY by default) as driver binaries keyed by a hash of
+// their sources, defines and the driver, and loaded from there instead of being compiled when a previous run
+// already built them. NULL disables the cache, everything is compiled from source
+void GlhSetProgramCacheDirectory(char* directory);
+// wait for a pending program to be compiled and linked, print the logs if it failed and query its uniforms.
+// called lazily by the render functions and GlhProgramGetUniformLocation, only needed to choose when to wait
+void GlhFinishProgram(GlhProgram *prg);
+// whether the program is ready, finishing it if the driver is done with it. never waits when the driver
+// compiles in parallel, otherwise there is no way to know without waiting and the program is finished right away
+bool GlhPollProgram(GlhProgram *prg);
+// GlhPollProgram on every one of programs (all of them are polled), true once they are all ready. to show
+// something else (like a loading screen) while the programs of a scene compile
+bool GlhPollPrograms(GlhProgram *programs[], int count);
 void GlhFreeProgram(GlhProgram *prg);
+// location of a uniform given to GlhInitProgram, -1 if it wasn't
+GLint GlhProgramGetUniformLocation(GlhProgram *prg, char* name);
 // initialize context, windowWidth and windowHeight can be 0, windowTitle can be NULL
 void GlhInitContext(GlhContext *ctx, int windowWidth, int windowHeight, char* windowTitle);
 void GlhFreeContext(GlhContext *ctx);
-// add GlhObject child to context. (child can be TextObject or Object)
+// add GlhObject child to context. (child can be TextObject, Object or Group)
 void GlhContextAppendChild(GlhContext *ctx, GlhElement *child);
+// add child to context as a child of parent (already in ctx), its transforms become relative to parent's
+// and cachedModelMatrix holds the world matrix. the contextIndex of the elements after it change
+void GlhContextAppendChildTo(GlhContext *ctx, GlhElement *parent, GlhElement *child);
+// parent of an element of ctx, NULL for the ones appended with GlhContextAppendChild
+GlhElement* GlhContextGetParent(GlhContext *ctx, GlhElement *el);
 // compute camera's view matrix, you most likely want to update it every frame
 void GlhComputeContextViewMatrix(GlhContext *ctx);
 // compute camera's projection matrix, does not need to be recomputed regularly unless specifics changes a made to the camera (fov, not transforms)
 void GlhComputeContextProjectionMatrix(GlhContext *ctx);
-// draw every object to the screen
+// recompute the camera matrices (and the viewport) flagged as dirty on ctx->camera, once per frame before rendering
+void GlhUpdateContextMatrices(GlhContext *ctx);
+// recompute the model matrices of the children whose transforms changed (and the camera block if the camera moved),
+// called by GlhRenderContext so the GlhUpdate*ModelMatrix functions aren't needed for children of a context
+void GlhUpdateContextTransforms(GlhContext *ctx);
+void GlhInitStreamBuffer(GlhStreamBuffer *stream, GLsizeiptr regionSize);
+void GlhFreeStreamBuffer(GlhStreamBuffer *stream);
+// room for size bytes in the current region (aligned to alignment), to be written through the returned pointer
+// and read by the GPU at *offset in stream->buffer. waits for the GPU if the region is still in use
+void* GlhStreamBufferAlloc(GlhStreamBuffer *stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr *offset);
+// fence what was written in the current region and move on to the next one
+void GlhStreamBufferNextRegion(GlhStreamBuffer *stream);
+// draw every object inside the camera frustum to the screen, objects are drawn sorted by program, texture and VAO
+// (front to back), then text objects, which are blended, back to front in one draw call per font
 void GlhRenderContext(GlhContext *ctx);
-void GlhInitMesh(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], vec3 indices[], int indicesCount, vec2 texcoords[], int texcoordsCount);
-// generates buffers for mesh, called internally, should not be called explicitly in most cases.
-void GlhGenerateMeshBuffers(GlhMesh *mesh);
+// indices are triangles of float indices (indicesCount of them), converted by GlhInitMeshIndexed
+void GlhInitMesh(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], vec3 indices[], int indicesCount, vec2 texcoords[], int texcoordsCount, int flags);
+// indicesCount indices, 3 per triangle. they are uploaded as 16 bits indices if verticiesCount allows it.
+// flags are GlhMeshLoadFlags, GLH_MESH_OPTIMIZE reorders the mesh's copy of the triangles and vertices for the
+// vertex caches (as GlhLoadMesh does for an OBJ) and prints the acmr before and after
+void GlhInitMeshIndexed(GlhMesh *mesh, vec3 verticies[], int verticiesCount, vec3 normals[], unsigned int indices[], int indicesCount, vec2 texcoords[], int texcoordsCount, int flags);
 void GlhFreeMesh(GlhMesh *mesh);
+// free the verticies, normals and texCoords vectors once they are on the GPU, if they aren't needed anymore.
+// the bounds and indexes are kept
+void GlhMeshDropCPUData(GlhMesh *mesh);
+typedef enum {
+    // reorder an imported OBJ (and the levels of detail) for the vertex caches
+    GLH_MESH_OPTIMIZE = 1,
+    // build a chain of levels of detail (see mesh_simplify), stored after the full mesh in its index buffer
+    GLH_MESH_LODS = 2
+} GlhMeshLoadFlags;
+
+// upload already indexed data (from mesh_data_import_obj or mesh_data_map) straight to the GPU, flags
+// being GlhMeshLoadFlags (GLH_MESH_OPTIMIZE only applies to the levels of detail, data isn't modified).
+// the mesh has no CPU copy (as after GlhMeshDropCPUData), data can be freed right after
+void GlhInitMeshFromData(GlhMesh *mesh, struct MeshData *data, int flags);
+// load a mesh file (mapped, see mesh_data_map), or import an OBJ file if filename ends in .obj.
+// GLH_MESH_OPTIMIZE reorders an imported OBJ for the vertex caches and prints the acmr before and after (mesh
+// files should be optimized before being written, see mesh_data_optimize), GLH_MESH_LODS builds the levels
+// of detail and prints their triangle counts. returns 0 on success, -1 otherwise
+int GlhLoadMesh(GlhMesh *mesh, char* filename, int flags);
 // render an object, called internaly and doesn't do any buffer swaping and such, should not be called explicitly in most cases
 void GlhRenderObject(GlhObject *obj, GlhContext *ctx);
 void GlhInitObject(GlhObject *obj, GLuint texture, vec3 scale, vec3 rotation, vec3 translation, GlhMesh *mesh, GlhProgram *program);
-// update object matrix, should be called after any change to the transforms of an object
+// update object matrix, only needed for objects that aren't children of a context (done by GlhRenderContext otherwise)
 void GlhUpdateObjectModelMatrix(GlhObject *obj);
 void GlhFreeObject(GlhObject *obj);
+// transforms can be NULL
+void GlhInitGroup(GlhGroup *grp, GlhTransforms *tsf);
 // used to load and setup a texture from a file
 int loadTexture(GLuint *texture, char* filename, bool alpha, GLenum interpolation);
 // initialize freetype, needs to be called before working with fonts, only once (or after freeing the last one)
@@ -198,19 +545,30 @@ void GlhFreeFreeType();
 void GlhInitFont(GlhFont *font, char* ttfFileName, int size, int glyphCount, float packingPrecision);
 void GlhFreeFont(GlhFont *font);
 float GlhFontGetTextWidth(GlhFont *font, char* text);
+// glyph data of a codepoint, the font's "no glyph" glyph if it doesn't have one
+GlhFontGLyphData* GlhFontGetGlyph(GlhFont *font, unsigned long codepoint);
 GlhBoundingBox GlhTextObjectGetBoundingBox(GlhTextObject *tob, float margin);
+// replace box by the world space box enclosing it once transformed (any rotation)
 void GlhApplyTransformsToBoundingBox(GlhBoundingBox *box, GlhTransforms transforms);
+void GlhTransformBoundingBox(GlhBoundingBox *box, mat4 model);
 void GlhTextObjectUpdateMesh(GlhTextObject *tob, char* OldString);
 void GlhUpdateTextObjectModelMatrix(GlhTextObject *tob);
 void GlhTextObjectSetText(GlhTextObject *tob, char* string);
 char* GlhTextObjectGetText(GlhTextObject *tob);
 // transforms can be NULL
 void GlhInitTextObject(GlhTextObject *tob, char* string, GlhFont *font, vec4 color, vec4 backgroundColor, GlhTransforms *tsf);
+// render a single text object through an offscreen FBO, GlhRenderContext uses the batched path instead
 void GlhRenderTextObject(GlhTextObject *tob, GlhContext *ctx);
 void GlhFreeTextObject(GlhTextObject *tob);
 GlhTransforms GlhGetIdentityTransform();
+// get an inactive FBO of type from the pool (created if none), cleared, until GlhReleaseFBO. doesn't query GL
 GlhFBO GlhRequestFBO(GlhFBOProvider *provider, GlhFBOType type);
-void GlhReleaseFBO(GlhFBOProvider provider, GlhFBO fbo);
+void GlhReleaseFBO(GlhFBOProvider *provider, GlhFBO fbo);
+// to call when the framebuffer is resized, window sized FBOs are recreated once the size
+// has been stable for GLH_FBO_RESIZE_DEBOUNCE seconds (checked by GlhFBOProviderUpdate)
+void GlhFBOProviderResize(GlhFBOProvider *provider, int width, int height);
+// applies a settled resize, called by GlhRenderContext every frame
+void GlhFBOProviderUpdate(GlhFBOProvider *provider);
 void saveImage(char* filepath, GLFWwindow* w);
 void GlhInitComputeShader(GlhComputeShader *cs, char* filename);
 void GlhRunComputeShader(GlhComputeShader *cs, GLuint inputTexture, GLuint outputTexture, GLenum sizedInFormat, GLenum sizedOutFormat, int workGroupsWidth, int workGroupsHeight);
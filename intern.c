@@ -0,0 +1,119 @@
+#include "intern.h"
+#include <string.h>
+#include <stdio.h>
+
+#define STRING_POOL_MIN_CAPACITY 64
+
+StringPool GlobalStringPool;
+
+bool globalStringPoolReady = false;
+
+// FNV-1a, never returns 0
+unsigned int hashString(char* string) {
+    unsigned int h = 2166136261u;
+    for(unsigned char* c = (unsigned char*)string; *c != '\0'; c++) {
+        h ^= *c;
+        h *= 16777619u;
+    }
+    return h == 0 ? 1 : h;
+}
+
+void string_pool_init(StringPool *pool) {
+    vector_init(&pool->chunks, 4, sizeof(char*));
+    pool->chunk = NULL;
+    pool->chunkUsed = 0;
+    pool->chunkSize = 0;
+    pool->slots = NULL;
+    pool->capacity = 0;
+    pool->size = 0;
+}
+
+// internal, index of the slot holding string, or of the empty slot where it would go
+int findStringSlot(StringPool *pool, char* string, unsigned int hash) {
+    int mask = pool->capacity - 1;
+    int i = hash & mask;
+    while(pool->slots[i].string != NULL) {
+        if(pool->slots[i].hash == hash && strcmp(pool->slots[i].string, string) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// internal, copy length bytes of string into the arena
+char* copyToArena(StringPool *pool, char* string, size_t length) {
+    if(pool->chunk == NULL || pool->chunkUsed + length > pool->chunkSize) {
+        // start a new chunk, the rest of the old one is just lost
+        pool->chunkSize = length > STRING_POOL_CHUNK_SIZE ? length : STRING_POOL_CHUNK_SIZE;
+        pool->chunk = malloc(pool->chunkSize);
+        pool->chunkUsed = 0;
+        vector_push(&pool->chunks, &pool->chunk);
+    }
+    char* copy = pool->chunk + pool->chunkUsed;
+    memcpy(copy, string, length);
+    pool->chunkUsed += length;
+    return copy;
+}
+
+// internal, double the table size and reinsert every string using the cached hashes
+void growStringPool(StringPool *pool) {
+    StringPoolSlot* oldSlots = pool->slots;
+    int oldCapacity = pool->capacity;
+    pool->capacity = oldCapacity == 0 ? STRING_POOL_MIN_CAPACITY : oldCapacity * 2;
+    pool->slots = calloc(pool->capacity, sizeof(StringPoolSlot));
+    int mask = pool->capacity - 1;
+    for(int i = 0; i < oldCapacity; i++) {
+        if(oldSlots[i].string == NULL) continue;
+        int j = oldSlots[i].hash & mask;
+        while(pool->slots[j].string != NULL) j = (j + 1) & mask;
+        pool->slots[j] = oldSlots[i];
+    }
+    free(oldSlots);
+}
+
+char* string_pool_intern(StringPool *pool, char* string) {
+    // keep the load factor under 3/4
+    if((pool->size + 1) * 4 > pool->capacity * 3) growStringPool(pool);
+    unsigned int hash = hashString(string);
+    int i = findStringSlot(pool, string, hash);
+    if(pool->slots[i].string == NULL) {
+        pool->slots[i].hash = hash;
+        pool->slots[i].string = copyToArena(pool, string, strlen(string) + 1);
+        pool->size++;
+    }
+    return pool->slots[i].string;
+}
+
+char* string_pool_find(StringPool *pool, char* string) {
+    if(pool->size == 0) return NULL;
+    return pool->slots[findStringSlot(pool, string, hashString(string))].string;
+}
+
+void string_pool_free(StringPool *pool) {
+    for(int i = 0; i < pool->chunks.size; i++) {
+        free(vector_get(pool->chunks.data, i, char*));
+    }
+    vector_free(pool->chunks);
+    free(pool->slots);
+    pool->slots = NULL;
+    pool->capacity = 0;
+    pool->size = 0;
+}
+
+char* intern_string(char* string) {
+    if(!globalStringPoolReady) {
+        string_pool_init(&GlobalStringPool);
+        globalStringPoolReady = true;
+    }
+    return string_pool_intern(&GlobalStringPool, string);
+}
+
+char* find_interned_string(char* string) {
+    if(!globalStringPoolReady) return NULL;
+    return string_pool_find(&GlobalStringPool, string);
+}
+
+void free_interned_strings() {
+    if(!globalStringPoolReady) return;
+    string_pool_free(&GlobalStringPool);
+    globalStringPoolReady = false;
+}
@@ -0,0 +1,43 @@
+#ifndef _INTERN_H
+#define _INTERN_H
+#include <stdbool.h>
+#include "vector.h"
+
+// size of the arena chunks strings are copied to (longer strings get a chunk of their own)
+#define STRING_POOL_CHUNK_SIZE 4096
+
+typedef struct {
+    unsigned int hash;
+    // NULL if the slot is empty
+    char* string;
+} StringPoolSlot;
+
+// pool of interned strings: every distinct string is copied once into an arena and
+// interning it again always gives back that same pointer, so interned strings can be
+// compared with == and stay valid until the pool is freed, whatever the caller does
+// with its own copy.
+typedef struct {
+    // char* of every allocated chunk, chunks never move once allocated
+    Vector chunks;
+    char* chunk;
+    size_t chunkUsed;
+    size_t chunkSize;
+    // open addressing table of every interned string (power of two capacity)
+    StringPoolSlot* slots;
+    int capacity;
+    int size;
+} StringPool;
+
+void string_pool_init(StringPool *pool);
+// returns the pool's copy of string, copying it in first if needed
+char* string_pool_intern(StringPool *pool, char* string);
+// returns the pool's copy of string, or NULL if it was never interned (never copies anything)
+char* string_pool_find(StringPool *pool, char* string);
+void string_pool_free(StringPool *pool);
+
+// same as above on the global pool shared by maps and events
+char* intern_string(char* string);
+char* find_interned_string(char* string);
+// frees the global pool, every interned string (and so every map key and event name) becomes invalid
+void free_interned_strings();
+#endif
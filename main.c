@@ -12,17 +12,38 @@
 #define DEBUG
 #include <cglm/cglm.h>
 #include "glhelper.h"
+#include "events.h"
 
 GlhContext ctx;
 int width = 640;
 int height = 480;
+// events posted from anywhere (any thread) are dispatched once per frame from the main loop
+struct EventBroadcaster events;
+struct EventQueue eventQueue;
+int togglePerspectiveEvent;
+// glfw input callbacks only record what happened, the events are coalesced
+// (only the latest of a frame is kept) and applied right before rendering
+int cursorEvent;
+int resizeEvent;
 
-void setUniforms(GlhObject *obj, GlhContext *ctx) {
-    mat4 mvp, mv;
-    glm_mat4_mul(ctx->cachedViewMatrix, obj->cachedModelMatrix, mv);
-    glm_mat4_mul(ctx->cachedProjectionMatrix, mv, mvp);
-    glUniformMatrix4fv(vector_get(obj->program->uniformsLocation.data, 0, GLint), 1, GL_FALSE,(float*) mvp);
-}
+typedef struct {
+    // glfwGetTime() when the callback was called
+    double time;
+    double x;
+    double y;
+} CursorInput;
+
+typedef struct {
+    double time;
+    int width;
+    int height;
+} ResizeInput;
+
+// oldest timestamp of the input applied this frame (-1 if none), to measure input to photon latency
+double frameInputTime = -1;
+double latencySum = 0;
+double latencyMax = 0;
+int latencySamples = 0;
 
 void handleDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) { 
     char* sev;
@@ -42,14 +63,31 @@ void handleDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
     printf("\033[32m[GLDEBUG]\033[0m%s%s: \033[34m%s\n\033[0m", sev, typ, message);
 }
 
-void framebuffer_size_callback(GLFWwindow* window, int wwidth, int wheight) {
-    width = wwidth;
-    height = wheight;
-    glViewport(0, 0, width, height);
-    GlhComputeContextProjectionMatrix(&ctx);
+// to know how late the oldest input shown on the next frame is
+void record_input_time(double time) {
+    if(frameInputTime < 0 || time < frameInputTime) frameInputTime = time;
 }
 
-void mouse_pos_callback(GLFWwindow *window, double xpos, double ypos) {
+// coalescing merge of the inputs, both start with their time: the event applied keeps the
+// time of the oldest one it replaces so that its latency isn't underestimated
+void keep_oldest_input_time(void* latest, void* older) {
+    double *time = latest;
+    *time = fmin(*time, *(double*)older);
+}
+
+void apply_resize(void* arg) {
+    ResizeInput *in = arg;
+    width = in->width;
+    height = in->height;
+    ctx.camera.projectionDirty = true;
+    GlhFBOProviderResize(&ctx.FBOProvider, width, height);
+    record_input_time(in->time);
+}
+
+void apply_cursor(void* arg) {
+    CursorInput *in = arg;
+    double xpos = in->x;
+    double ypos = in->y;
     double yaw = (xpos / width * 2 - 1) * (M_PI_2);
     double pitch = (ypos / height * 2 - 1) * (M_PI_2);
     double roll = 0;
@@ -63,14 +101,29 @@ void mouse_pos_callback(GLFWwindow *window, double xpos, double ypos) {
     ctx.camera.rotation[0] = pitch;
     ctx.camera.rotation[1] = yaw;
     ctx.camera.rotation[2] = roll;
-    GlhComputeContextViewMatrix(&ctx);
+    ctx.camera.viewDirty = true;
+    record_input_time(in->time);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int wwidth, int wheight) {
+    ResizeInput in = {glfwGetTime(), wwidth, wheight};
+    event_queue_post(&eventQueue, resizeEvent, &in, sizeof(in));
+}
+
+void mouse_pos_callback(GLFWwindow *window, double xpos, double ypos) {
+    CursorInput in = {glfwGetTime(), xpos, ypos};
+    event_queue_post(&eventQueue, cursorEvent, &in, sizeof(in));
+}
+
+void toggle_perspective(void* arg) {
+    ctx.camera.perspective = !ctx.camera.perspective;
+    ctx.camera.projectionDirty = true;
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (key == GLFW_KEY_E && action == GLFW_PRESS) {
-        ctx.camera.perspective = !ctx.camera.perspective;
-            GlhComputeContextProjectionMatrix(&ctx);
+        event_queue_post(&eventQueue, togglePerspectiveEvent, NULL, 0);
     }
 }
 
@@ -81,11 +134,32 @@ int main() {
         return -1;
     }
     GlhInitContext(&ctx, 640, 480, "nothing here");
+    // submitted first, so it compiles along with the global shaders (submitted by GlhInitContext) while the rest
+    // is set up. the program is instanced, the model matrix is an attribute and the camera comes from its block,
+    // so there is no uniform to set per object
+    char* uniforms[] = {
+        "uTexture"
+    };
+
+    GlhProgram prg;
+    GlhInitProgram(&prg, "shaders/shader.frag", "shaders/instanced.vert", uniforms, 1, NULL);
 
     printf("\033[31mGL version: %s\n\033[0m", glGetString(GL_VERSION));
     glEnable(GL_DEBUG_OUTPUT);
     glDebugMessageCallback(handleDebugMessage, NULL);
 
+    events_init(&events);
+    event_queue_init(&eventQueue, &events, 256);
+    togglePerspectiveEvent = events_register(&events, "toggle_perspective");
+    events_subscribe_id(&events, togglePerspectiveEvent, toggle_perspective, NULL);
+    cursorEvent = events_register(&events, "cursor");
+    resizeEvent = events_register(&events, "resize");
+    events_subscribe_id(&events, cursorEvent, apply_cursor, NULL);
+    events_subscribe_id(&events, resizeEvent, apply_resize, NULL);
+    // only the final position / size of a frame matters
+    event_queue_set_coalescing(&eventQueue, cursorEvent, true, keep_oldest_input_time);
+    event_queue_set_coalescing(&eventQueue, resizeEvent, true, keep_oldest_input_time);
+
     glfwSetFramebufferSizeCallback(ctx.window, framebuffer_size_callback);
     glfwSetCursorPosCallback(ctx.window, mouse_pos_callback);
     glfwSetKeyCallback(ctx.window, key_callback);
@@ -108,17 +182,12 @@ int main() {
         vec2 texcoords[] = {
             {0, 0}, {0, 1}, {1, 1}, {1, 0}
         };
-        GlhInitMesh(&quadMesh, verticies, sizeof(verticies) / sizeof(verticies[0]), normals, indices, sizeof(indices) / sizeof(indices[0]), texcoords, sizeof(texcoords) / sizeof(texcoords[0]));
+        GlhInitMesh(&quadMesh, verticies, sizeof(verticies) / sizeof(verticies[0]), normals, indices, sizeof(indices) / sizeof(indices[0]), texcoords, sizeof(texcoords) / sizeof(texcoords[0]), 0);
+        // never read back on the CPU
+        GlhMeshDropCPUData(&quadMesh);
         printf("\n");
     }
 
-    char* uniforms[] = {
-        "MVP"
-    };
-
-    GlhProgram prg;
-    GlhInitProgram(&prg, "shaders/shader.frag", "shaders/shader.vert", uniforms, 1, setUniforms);
-
     GlhFont font;
     GlhInitFont(&font, "fonts/Roboto-Regular.ttf", 128, -1, 0.95);
 
@@ -148,15 +217,18 @@ int main() {
     GlhInitObject(&plane, tex, GLM_VEC3_ONE, GLM_VEC3_ZERO, GLM_VEC3_ZERO, &quadMesh, &prg);
     plane.transforms.translation[2] = -2.5;
 
+    // the labels are positioned relative to the menu, moving it moves all of them
+    GlhGroup menu;
+    GlhInitGroup(&menu, NULL);
+
     GlhContextAppendChild(&ctx, (GlhElement*)&plane);
-    GlhContextAppendChild(&ctx, (GlhElement*)&to0);
-    GlhContextAppendChild(&ctx, (GlhElement*)&to1);
-    GlhContextAppendChild(&ctx, (GlhElement*)&to2);
-    GlhContextAppendChild(&ctx, (GlhElement*)&to3);
+    GlhContextAppendChild(&ctx, (GlhElement*)&menu);
+    GlhContextAppendChildTo(&ctx, (GlhElement*)&menu, (GlhElement*)&to0);
+    GlhContextAppendChildTo(&ctx, (GlhElement*)&menu, (GlhElement*)&to1);
+    GlhContextAppendChildTo(&ctx, (GlhElement*)&menu, (GlhElement*)&to2);
+    GlhContextAppendChildTo(&ctx, (GlhElement*)&menu, (GlhElement*)&to3);
 
-    GlhComputeContextProjectionMatrix(&ctx);
-    GlhComputeContextViewMatrix(&ctx);
-    glClearColor(1, 1, 1, 1);
+    GlhClearColor(1, 1, 1, 1);
 
     GlhBoundingBox box0 = GlhTextObjectGetBoundingBox(&to0, 0.2);
     GlhBoundingBox box1 = GlhTextObjectGetBoundingBox(&to1, 0.2);
@@ -175,13 +247,16 @@ int main() {
     float to3width = box3.end[0] - box3.start[0];
     float to3height = box3.end[1] - box3.start[1];
     while(!(glfwWindowShouldClose(ctx.window))) {
+        // everything posted since last frame, in one batch
+        event_queue_dispatch(&eventQueue);
+        // then recompute the camera matrices once, if the input changed them
+        GlhUpdateContextMatrices(&ctx);
         float ratio = (float) width / height;
         float texRatio = 1920.0 / 1072;
 
         if(ratio > texRatio) {
             plane.transforms.scale[0] = ratio;
             plane.transforms.scale[1] = ratio / texRatio;
-            GlhUpdateObjectModelMatrix(&plane);
         }
 
         to0.transforms.translation[0] = 0.1 * to0.transforms.scale[0] - to0width / 2;
@@ -192,20 +267,30 @@ int main() {
         to2.transforms.translation[1] = 0.2 * to2.transforms.scale[1] - to2height / 2 + 0.0;
         to3.transforms.translation[0] = 0.1 * to3.transforms.scale[0] - to3width / 2;
         to3.transforms.translation[1] = 0.2 * to3.transforms.scale[1] - to3height / 2 + -0.3;
-        GlhUpdateTextObjectModelMatrix(&to0);
-        GlhUpdateTextObjectModelMatrix(&to1);
-        GlhUpdateTextObjectModelMatrix(&to2);
-        GlhUpdateTextObjectModelMatrix(&to3);
+        // the model matrices of what changed are recomputed by GlhRenderContext
 
         GlhRenderContext(&ctx);
         glfwSwapBuffers(ctx.window);
+        // swap returning is as close to the photons as we can easily get
+        if(frameInputTime >= 0) {
+            double latency = glfwGetTime() - frameInputTime;
+            latencySum += latency;
+            latencyMax = latency > latencyMax ? latency : latencyMax;
+            latencySamples++;
+            frameInputTime = -1;
+        }
         glfwPollEvents();
     }
 
     GlhFreeMesh(&quadMesh);
     GlhFreeObject(&plane);
     GlhFreeProgram(&prg);
+    if(latencySamples > 0) {
+        printf("input to present latency: avg %.2fms, max %.2fms (%i frames with input)\n", latencySum / latencySamples * 1000, latencyMax * 1000, latencySamples);
+    }
     GlhFreeContext(&ctx);
+    event_queue_free(&eventQueue);
+    events_free(&events);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -1,56 +1,304 @@
 #include "maps.h"
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 
+// smallest capacity allocated on the first set
+#define MAP_MIN_CAPACITY 8
+// seeds tried for a bucket of a frozen map before giving up (see map_freeze)
+#define FROZEN_MAP_MAX_SEEDS (1 << 20)
+
+// keys are interned, so hashing the pointer is enough (and doesn't read the string)
+unsigned int hashMapKey(char* key) {
+    uint64_t p = (uintptr_t)key;
+    p ^= p >> 33;
+    p *= 0xff51afd7ed558ccdULL;
+    p ^= p >> 33;
+    return (unsigned int)p;
+}
+
 void map_init(Map *map, size_t dataSize) {
     map->dataSize = dataSize;
-    vector_init(&map->keyVector, 5, sizeof(char*));
-    vector_init(&map->valuesVector, 5, dataSize);
+    // nothing is allocated until the first set, so empty maps are free
+    map->slots = NULL;
+    map->values = NULL;
+    map->capacity = 0;
+    map->size = 0;
 }
 
-int getKeyIndex(Map *map, char* key) {
-    for(int i = 0; i < map->keyVector.size; i++) {
-        if(strcmp(vector_get(map->keyVector.data, i, char*), key) == 0) {
+// returns the slot index of an interned key (NULL for a string that was never interned, which can't be
+// a key of any map), or -1 if it isn't in the map
+int getKeyIndex(Map *map, char* interned) {
+    if(map->size == 0 || interned == NULL) return -1;
+    unsigned int hash = hashMapKey(interned);
+    int mask = map->capacity - 1;
+    // there is always at least one empty slot, so this ends
+    for(int i = hash & mask; map->slots[i].key != NULL; i = (i + 1) & mask) {
+        if(map->slots[i].key == interned) {
             return i;
         }
     }
     return -1;
 }
 
+// internal, put an entry known not to be in the map in the first free slot of its probe chain
+void insertMapEntry(Map *map, unsigned int hash, char* key, void* value) {
+    int mask = map->capacity - 1;
+    int i = hash & mask;
+    while(map->slots[i].key != NULL) i = (i + 1) & mask;
+    map->slots[i].hash = hash;
+    map->slots[i].key = key;
+    memcpy(map->values + i * map->dataSize, value, map->dataSize);
+    map->size++;
+}
+
+// internal, reallocate the map with newCapacity slots and rehash (with the cached hashes) every entry in it
+void resizeMap(Map *map, int newCapacity) {
+    MapSlot* oldSlots = map->slots;
+    void* oldValues = map->values;
+    int oldCapacity = map->capacity;
+    map->slots = calloc(newCapacity, sizeof(MapSlot));
+    map->values = malloc(newCapacity * map->dataSize);
+    map->capacity = newCapacity;
+    map->size = 0;
+    for(int i = 0; i < oldCapacity; i++) {
+        if(oldSlots[i].key != NULL) {
+            insertMapEntry(map, oldSlots[i].hash, oldSlots[i].key, oldValues + i * map->dataSize);
+        }
+    }
+    free(oldSlots);
+    free(oldValues);
+}
+
 bool map_has(Map *map, char* key) {
-    return getKeyIndex(map, key) != -1;
+    return getKeyIndex(map, find_interned_string(key)) != -1;
+}
+
+bool map_has_interned(Map *map, char* interned) {
+    return getKeyIndex(map, interned) != -1;
 }
 
 void map_set(Map *map, char* key, void* value) {
-    int i = getKeyIndex(map, key);
+    // interned up front, it is needed to insert anyway
+    map_set_interned(map, intern_string(key), value);
+}
+
+void map_set_interned(Map *map, char* interned, void* value) {
+    int i = getKeyIndex(map, interned);
     if(i != -1) {
-        vector_set(&map->valuesVector, value, i);
-    } else {
-        vector_push(&map->keyVector, &key);
-        vector_push(&map->valuesVector, value);
+        memcpy(map->values + i * map->dataSize, value, map->dataSize);
+        return;
+    }
+    // keep the load factor under 3/4 to keep probe chains short
+    if((map->size + 1) * 4 > map->capacity * 3) {
+        resizeMap(map, map->capacity == 0 ? MAP_MIN_CAPACITY : map->capacity * 2);
     }
+    insertMapEntry(map, hashMapKey(interned), interned, value);
+}
+
+void* map_get_pointer(Map *map, char* key) {
+    return map_get_pointer_interned(map, find_interned_string(key));
+}
+
+void* map_get_pointer_interned(Map *map, char* interned) {
+    int i = getKeyIndex(map, interned);
+    return i != -1 ? map->values + i * map->dataSize : NULL;
 }
 
 void map_get(Map *map, char* key, void* data) {
-    int i = getKeyIndex(map, key);
+    map_get_interned(map, find_interned_string(key), data);
+}
+
+void map_get_interned(Map *map, char* interned, void* data) {
+    int i = getKeyIndex(map, interned);
     if(i != -1) {
-        memcpy(data, map->valuesVector.data + i * map->dataSize, map->dataSize);
+        memcpy(data, map->values + i * map->dataSize, map->dataSize);
     } else {
         printf("WARN: trying to get unset value in map\n");
     }
 }
 
 void map_delete(Map *map, char* key) {
-    int i = getKeyIndex(map, key);
-    if(i != -1) {
-        vector_splice(&map->keyVector, i, 1, NULL);
-        vector_splice(&map->valuesVector, i, 1, NULL);
-    } else {
+    int i = getKeyIndex(map, find_interned_string(key));
+    if(i == -1) {
         printf("WARN: trying to delete unset key in map (double delete ?)\n");
+        return;
+    }
+    // backward shift deletion: move every following entry of the probe chain that would
+    // be unreachable because of the hole back into it, until an empty slot is reached
+    int mask = map->capacity - 1;
+    int j = i;
+    while(true) {
+        j = (j + 1) & mask;
+        if(map->slots[j].key == NULL) break;
+        int ideal = map->slots[j].hash & mask;
+        // the entry at j can fill the hole at i only if its ideal slot is not in ]i, j] (cyclically)
+        bool reachable = i <= j ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+        if(reachable) continue;
+        map->slots[i] = map->slots[j];
+        memcpy(map->values + i * map->dataSize, map->values + j * map->dataSize, map->dataSize);
+        i = j;
     }
+    map->slots[i].key = NULL;
+    map->size--;
 }
 
 void map_free(Map *map) {
-    vector_free(map->keyVector);
-    vector_free(map->valuesVector);
-}
\ No newline at end of file
+    free(map->slots);
+    free(map->values);
+}
+
+// internal, 64 bits hash of the string of a frozen map key, mixed 8 bytes at a time. frozen maps hash the string
+// itself rather than its interned pointer, so a lookup doesn't go through the string pool. the high 32 bits pick
+// the bucket and the low 32 bits the slot, so two keys sharing both halves can never be separated (see map_freeze)
+uint64_t hashFrozenString(char* key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint64_t word = 0;
+    int shift = 0;
+    for(unsigned char* c = (unsigned char*)key; *c != '\0'; c++) {
+        word |= (uint64_t)*c << shift;
+        shift += 8;
+        if(shift == 64) {
+            h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+            word = 0;
+            shift = 0;
+        }
+    }
+    // the partial last word, with the length in bytes of it so that trailing zeros aren't lost
+    h = (h ^ word ^ ((uint64_t)shift << 56)) * 0x9e3779b97f4a7c15ULL;
+    // spread the words over every bit, the bucket comes from the high ones and the slot from the low ones
+    h ^= h >> 32;
+    h *= 0xff51afd7ed558ccdULL;
+    return h ^ (h >> 29);
+}
+
+// internal, x mapped to [0, n[ with a multiply and a shift instead of a division (x being a uniform 32 bits hash)
+unsigned int reduceFrozenHash(unsigned int x, unsigned int n) {
+    return (unsigned int)(((uint64_t)x * n) >> 32);
+}
+
+// internal, seeded slot hash of a key for frozen maps, from the low bits of its string hash
+unsigned int hashFrozenKey(uint64_t hash, unsigned int seed) {
+    unsigned int x = (unsigned int)hash ^ seed * 0x9e3779b9u;
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    return x ^ (x >> 13);
+}
+
+// internal, offset rounded up so that what's placed there is suitably aligned
+size_t alignFrozenMapOffset(size_t offset) {
+    return (offset + 15) & ~(size_t)15;
+}
+
+// internal, qsort comparator putting the biggest buckets first ({bucket, start, count} triples)
+int compareBucketSizes(const void* a, const void* b) {
+    return ((int*)b)[2] - ((int*)a)[2];
+}
+
+int map_freeze(Map *map, FrozenMap *frozen) {
+    // hash and displace: keys are split into buckets with the high bits of their hash, then, biggest
+    // buckets first, a seed is searched for every bucket so that all its keys land in free slots
+    int n = map->size;
+    int r = n / 2 + 1;
+    frozen->size = n;
+    frozen->bucketCount = r;
+    frozen->dataSize = map->dataSize;
+    size_t seedsOffset = alignFrozenMapOffset(n * sizeof(char*));
+    size_t valuesOffset = alignFrozenMapOffset(seedsOffset + r * sizeof(unsigned int));
+    frozen->block = calloc(1, valuesOffset + n * map->dataSize + 1);
+    frozen->keys = frozen->block;
+    frozen->seeds = frozen->block + seedsOffset;
+    frozen->values = frozen->block + valuesOffset;
+    if(n == 0) return 0;
+
+    // {bucket, start, count} of every bucket, start being where its keys are in grouped
+    int (*buckets)[3] = calloc(r, sizeof(int[3]));
+    // map slot index of every key, grouped by bucket
+    int* grouped = malloc(n * sizeof(int));
+    // string hash of the key of every map slot
+    uint64_t* hashes = malloc(map->capacity * sizeof(uint64_t));
+    for(int i = 0; i < map->capacity; i++) {
+        if(map->slots[i].key == NULL) continue;
+        hashes[i] = hashFrozenString(map->slots[i].key);
+        buckets[reduceFrozenHash(hashes[i] >> 32, r)][2]++;
+    }
+    for(int b = 0, start = 0; b < r; b++) {
+        buckets[b][0] = b;
+        buckets[b][1] = start;
+        start += buckets[b][2];
+        // reused as a fill counter, restored below
+        buckets[b][2] = 0;
+    }
+    for(int i = 0; i < map->capacity; i++) {
+        if(map->slots[i].key == NULL) continue;
+        int b = reduceFrozenHash(hashes[i] >> 32, r);
+        grouped[buckets[b][1] + buckets[b][2]++] = i;
+    }
+    qsort(buckets, r, sizeof(int[3]), compareBucketSizes);
+
+    int* positions = malloc(n * sizeof(int));
+    bool placed = true;
+    for(int b = 0; b < r && buckets[b][2] > 0 && placed; b++) {
+        int* slots = grouped + buckets[b][1];
+        int count = buckets[b][2];
+        // try seeds until every key of the bucket gets a distinct free slot. the slot only depends on the low 32 bits
+        // of the hash, keys of a bucket sharing them always collide, hence the limit
+        placed = false;
+        for(unsigned int seed = 1; seed <= FROZEN_MAP_MAX_SEEDS && !placed; seed++) {
+            bool fits = true;
+            for(int k = 0; k < count && fits; k++) {
+                positions[k] = reduceFrozenHash(hashFrozenKey(hashes[slots[k]], seed), n);
+                if(frozen->keys[positions[k]] != NULL) fits = false;
+                for(int l = 0; l < k && fits; l++) {
+                    if(positions[l] == positions[k]) fits = false;
+                }
+            }
+            if(!fits) continue;
+            frozen->seeds[buckets[b][0]] = seed;
+            for(int k = 0; k < count; k++) {
+                frozen->keys[positions[k]] = map->slots[slots[k]].key;
+                memcpy(frozen->values + positions[k] * map->dataSize, map->values + slots[k] * map->dataSize, map->dataSize);
+            }
+            placed = true;
+        }
+    }
+    free(buckets);
+    free(grouped);
+    free(hashes);
+    free(positions);
+    if(!placed) {
+        printf("ERROR: map_freeze, no seed found to place the %i keys, the frozen map is left empty\n", n);
+        // an empty map, every lookup misses
+        frozen->size = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void* frozen_map_get_pointer(FrozenMap *frozen, char* key) {
+    if(frozen->size == 0) return NULL;
+    // a single pass over the string and a single probe
+    uint64_t hash = hashFrozenString(key);
+    unsigned int seed = frozen->seeds[reduceFrozenHash(hash >> 32, frozen->bucketCount)];
+    int i = reduceFrozenHash(hashFrozenKey(hash, seed), frozen->size);
+    // keys that aren't in the map still land somewhere, hence the check (an interned key is the same pointer)
+    char* found = frozen->keys[i];
+    return found == key || strcmp(found, key) == 0 ? frozen->values + i * frozen->dataSize : NULL;
+}
+
+bool frozen_map_has(FrozenMap *frozen, char* key) {
+    return frozen_map_get_pointer(frozen, key) != NULL;
+}
+
+void frozen_map_get(FrozenMap *frozen, char* key, void* data) {
+    void* value = frozen_map_get_pointer(frozen, key);
+    if(value != NULL) {
+        memcpy(data, value, frozen->dataSize);
+    } else {
+        printf("WARN: trying to get unset value in frozen map\n");
+    }
+}
+
+void frozen_map_free(FrozenMap *frozen) {
+    free(frozen->block);
+}
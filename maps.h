@@ -1,25 +1,77 @@
+#ifndef _MAPS_H
+#define _MAPS_H
 #include "vector.h"
+#include "intern.h"
 #include <ctype.h>
 #include <stdbool.h>
 
 #define map_print(map, type, format) \
 printf("{\n"); \
-for(int __i = 0; __i < map.keyVector.size; __i++) { \
-    printf("   \"%s\": ", vector_get(map.keyVector.data, __i, char*)); \
-    printf(format, vector_get(map.valuesVector.data, __i, type)); \
+for(int __i = 0; __i < (map).capacity; __i++) { \
+    if((map).slots[__i].key == NULL) continue; \
+    printf("   \"%s\": ", (map).slots[__i].key); \
+    printf(format, vector_get((map).values, __i, type)); \
     printf("\n"); \
 } \
 printf("}")
 
 typedef struct {
-    Vector keyVector;
-    Vector valuesVector;
+    // cached hash of the key
+    unsigned int hash;
+    // interned key, NULL if the slot is empty
+    char* key;
+} MapSlot;
+
+// hash map with open addressing (linear probing), deleting shifts the following
+// entries back instead of leaving tombstones, so probe chains never grow with deletes.
+// slots and values are parallel arrays of capacity elements, capacity is always a power of two
+// keys are interned (see intern.h) so the caller's strings don't need to outlive the map,
+// and slots are compared by pointer
+typedef struct {
+    MapSlot* slots;
+    void* values;
+    int capacity;
+    int size;
     size_t dataSize;
 } Map;
 
+// read only copy of a Map with a minimal perfect hash: every key has a slot of its own, found
+// through the seed of its bucket, so a lookup is a hash of the string, a single probe with no collision
+// chain and a single strcmp (the string pool isn't involved, keys don't need to be interned).
+// keys, seeds and values all live in one contiguous allocation (block).
+typedef struct {
+    int size;
+    int bucketCount;
+    size_t dataSize;
+    // interned keys, the slot of a key is its index
+    char** keys;
+    // hash seed of every bucket
+    unsigned int* seeds;
+    void* values;
+    void* block;
+} FrozenMap;
+
 void map_init(Map *map, size_t dataSize);
 void map_set(Map *map, char* key, void* value);
 bool map_has(Map *map, char* key);
 void map_get(Map *map, char* key, void* data);
+// pointer to the value of key, NULL if it isn't in the map (a single lookup instead of map_has then map_get)
+void* map_get_pointer(Map *map, char* key);
 void map_delete(Map *map, char* key);
-void map_free(Map *map);
\ No newline at end of file
+// same as above with a key that is already interned (intern_string), for callers keeping their keys interned:
+// the string itself is never read, the global pool isn't looked up
+bool map_has_interned(Map *map, char* interned);
+void map_set_interned(Map *map, char* interned, void* value);
+void map_get_interned(Map *map, char* interned, void* data);
+void* map_get_pointer_interned(Map *map, char* interned);
+void map_free(Map *map);
+// build the frozen version of map, map is left untouched and can be freed right after. returns 0 on success, -1 if
+// the keys couldn't be placed (only when some of them share most of their hash bits), frozen is then an empty map
+// that still has to be freed
+int map_freeze(Map *map, FrozenMap *frozen);
+bool frozen_map_has(FrozenMap *frozen, char* key);
+void frozen_map_get(FrozenMap *frozen, char* key, void* data);
+// pointer to the value of key in the frozen map, NULL if it isn't in it
+void* frozen_map_get_pointer(FrozenMap *frozen, char* key);
+void frozen_map_free(FrozenMap *frozen);
+#endif
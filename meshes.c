@@ -0,0 +1,613 @@
+#include "meshes.h"
+#include "vector.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// internal, position / texcoord / normal indices of a face corner (0 based, -1 when absent)
+typedef struct {
+    int v;
+    int vt;
+    int vn;
+} ObjCorner;
+
+// internal, open addressing (linear probing) table from a corner to the vertex made from it.
+// capacity is always a power of two, kept at least twice the size
+typedef struct {
+    ObjCorner *keys;
+    int *vertices;
+    int capacity;
+    int size;
+} CornerTable;
+
+unsigned int hashCorner(ObjCorner c) {
+    unsigned int h = (unsigned int) c.v * 0x9e3779b1u;
+    h ^= (unsigned int) c.vt * 0x85ebca77u + (h << 6) + (h >> 2);
+    h ^= (unsigned int) c.vn * 0xc2b2ae3du + (h << 6) + (h >> 2);
+    return h ^ (h >> 16);
+}
+
+void initCornerTable(CornerTable *table, int capacity) {
+    table->capacity = capacity;
+    table->size = 0;
+    table->keys = malloc(capacity * sizeof(ObjCorner));
+    table->vertices = malloc(capacity * sizeof(int));
+    // -1 marks an empty slot
+    for(int i = 0; i < capacity; i++) table->vertices[i] = -1;
+}
+
+// internal, slot of c, or of where it would go
+int cornerSlot(CornerTable *table, ObjCorner c) {
+    int mask = table->capacity - 1;
+    int slot = hashCorner(c) & mask;
+    while(table->vertices[slot] != -1) {
+        ObjCorner k = table->keys[slot];
+        if(k.v == c.v && k.vt == c.vt && k.vn == c.vn) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void growCornerTable(CornerTable *table) {
+    CornerTable grown;
+    initCornerTable(&grown, table->capacity * 2);
+    for(int i = 0; i < table->capacity; i++) {
+        if(table->vertices[i] == -1) continue;
+        int slot = cornerSlot(&grown, table->keys[i]);
+        grown.keys[slot] = table->keys[i];
+        grown.vertices[slot] = table->vertices[i];
+    }
+    grown.size = table->size;
+    free(table->keys);
+    free(table->vertices);
+    *table = grown;
+}
+
+// internal, parse a face corner (v, v/vt, v//vn or v/vt/vn) at *p, resolving negative (relative) indices.
+// returns false if it is malformed or out of range
+bool parseCorner(char **p, int counts[3], ObjCorner *corner) {
+    int values[3] = {0, 0, 0};
+    char *end;
+    for(int i = 0; i < 3; i++) {
+        // v is mandatory, vt can be skipped with v//vn
+        if(i > 0) {
+            if(**p != '/') break;
+            (*p)++;
+            if(i == 1 && **p == '/') continue;
+        }
+        long index = strtol(*p, &end, 10);
+        if(end == *p) return false;
+        *p = end;
+        // 1 based, negative ones count back from the last element read so far
+        index = index < 0 ? counts[i] + index : index - 1;
+        if(index < 0 || index >= counts[i]) return false;
+        values[i] = index + 1;
+    }
+    corner->v = values[0] - 1;
+    corner->vt = values[1] - 1;
+    corner->vn = values[2] - 1;
+    return true;
+}
+
+// internal, index of the vertex of a corner, creating it if it is the first time the corner is seen
+unsigned int cornerVertex(CornerTable *table, Vector *vertices, Vector_float *attributes[3], ObjCorner c) {
+    int slot = cornerSlot(table, c);
+    if(table->vertices[slot] != -1) return table->vertices[slot];
+    MeshVertex vertex = {};
+    memcpy(vertex.position, attributes[0]->data + c.v * 3, sizeof(vertex.position));
+    if(c.vt >= 0) memcpy(vertex.texCoord, attributes[1]->data + c.vt * 2, sizeof(vertex.texCoord));
+    if(c.vn >= 0) memcpy(vertex.normal, attributes[2]->data + c.vn * 3, sizeof(vertex.normal));
+    int index = vertices->size;
+    vector_push(vertices, &vertex);
+    table->keys[slot] = c;
+    table->vertices[slot] = index;
+    if(++table->size * 2 > table->capacity) growCornerTable(table);
+    return index;
+}
+
+int mesh_data_import_obj(struct MeshData *data, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL) {
+        printf("ERROR: mesh_data_import_obj, unable to open %s\n", filename);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *source = malloc(size + 1);
+    size = fread(source, 1, size, file);
+    fclose(file);
+    source[size] = '\0';
+
+    Vector_float positions, texCoords, normals;
+    vector_float_init(&positions, 3 * 64);
+    vector_float_init(&texCoords, 2 * 64);
+    vector_float_init(&normals, 3 * 64);
+    Vector_float *attributes[3] = {&positions, &texCoords, &normals};
+    Vector vertices, indices;
+    vector_init(&vertices, 64, sizeof(MeshVertex));
+    vector_init(&indices, 3 * 64, sizeof(unsigned int));
+    CornerTable table;
+    initCornerTable(&table, 256);
+    int line = 1;
+    bool failed = false;
+    for(char *p = source; *p != '\0' && !failed; line++) {
+        char *end;
+        if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            for(int i = 0; i < 3; i++) vector_float_push(&positions, strtof(p, &p));
+        } else if(p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')) {
+            p += 3;
+            for(int i = 0; i < 2; i++) vector_float_push(&texCoords, strtof(p, &p));
+        } else if(p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')) {
+            p += 3;
+            for(int i = 0; i < 3; i++) vector_float_push(&normals, strtof(p, &p));
+        } else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            int counts[3] = {positions.size / 3, texCoords.size / 2, normals.size / 3};
+            // triangulated as a fan around the first corner
+            unsigned int first = 0, previous = 0;
+            int corners = 0;
+            while(true) {
+                while(*p == ' ' || *p == '\t') p++;
+                if(*p == '\n' || *p == '\r' || *p == '\0') break;
+                ObjCorner corner;
+                if(!parseCorner(&p, counts, &corner)) {
+                    printf("ERROR: mesh_data_import_obj, invalid face in %s at line %i\n", filename, line);
+                    failed = true;
+                    break;
+                }
+                unsigned int vertex = cornerVertex(&table, &vertices, attributes, corner);
+                if(corners == 0) first = vertex;
+                if(corners >= 2) {
+                    unsigned int triangle[3] = {first, previous, vertex};
+                    vector_push_array(&indices, triangle, 3);
+                }
+                previous = vertex;
+                corners++;
+            }
+        }
+        // anything else (comments, objects, groups, materials...) is ignored
+        end = strchr(p, '\n');
+        p = end != NULL ? end + 1 : p + strlen(p);
+    }
+    free(source);
+    free(table.keys);
+    free(table.vertices);
+    vector_float_free(positions);
+    vector_float_free(texCoords);
+    vector_float_free(normals);
+    if(failed) {
+        vector_free(vertices);
+        vector_free(indices);
+        return -1;
+    }
+    // the vectors' storage is handed over as is
+    data->vertices = vertices.data;
+    data->vertexCount = vertices.size;
+    data->indices = indices.data;
+    data->indexCount = indices.size;
+    data->mapping = NULL;
+    data->mappingSize = 0;
+    for(int a = 0; a < 3; a++) {
+        data->min[a] = data->vertexCount > 0 ? INFINITY : 0;
+        data->max[a] = data->vertexCount > 0 ? -INFINITY : 0;
+    }
+    for(int i = 0; i < data->vertexCount; i++) {
+        for(int a = 0; a < 3; a++) {
+            data->min[a] = fminf(data->min[a], data->vertices[i].position[a]);
+            data->max[a] = fmaxf(data->max[a], data->vertices[i].position[a]);
+        }
+    }
+    return 0;
+}
+
+int mesh_data_write(const struct MeshData *data, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    if(file == NULL) {
+        printf("ERROR: mesh_data_write, unable to open %s\n", filename);
+        return -1;
+    }
+    MeshFileHeader header = {MESH_FILE_MAGIC, MESH_FILE_VERSION, data->vertexCount, data->indexCount};
+    memcpy(header.min, data->min, sizeof(header.min));
+    memcpy(header.max, data->max, sizeof(header.max));
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(data->vertices, sizeof(MeshVertex), data->vertexCount, file) == (size_t) data->vertexCount
+        && fwrite(data->indices, sizeof(unsigned int), data->indexCount, file) == (size_t) data->indexCount;
+    if(fclose(file) != 0 || !written) {
+        printf("ERROR: mesh_data_write, unable to write %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+int mesh_data_map(struct MeshData *data, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        printf("ERROR: mesh_data_map, unable to open %s\n", filename);
+        return -1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(MeshFileHeader)) {
+        printf("ERROR: mesh_data_map, %s is not a mesh file\n", filename);
+        close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid once the file is closed
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        printf("ERROR: mesh_data_map, unable to map %s\n", filename);
+        return -1;
+    }
+    const MeshFileHeader *header = mapping;
+    size_t expected = sizeof(MeshFileHeader) + (size_t) header->vertexCount * sizeof(MeshVertex) + (size_t) header->indexCount * sizeof(unsigned int);
+    if(header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION || expected != (size_t) st.st_size) {
+        printf("ERROR: mesh_data_map, %s is not a mesh file (or not of this version)\n", filename);
+        munmap(mapping, st.st_size);
+        return -1;
+    }
+    // the indices go straight to the GPU, a corrupted file must not make it read past the vertices
+    const unsigned int *indices = (const unsigned int*) ((const MeshVertex*) (header + 1) + header->vertexCount);
+    bool validIndices = header->indexCount % 3 == 0;
+    for(unsigned int i = 0; validIndices && i < header->indexCount; i++) validIndices = indices[i] < header->vertexCount;
+    if(!validIndices) {
+        printf("ERROR: mesh_data_map, %s has invalid indices\n", filename);
+        munmap(mapping, st.st_size);
+        return -1;
+    }
+    data->vertexCount = header->vertexCount;
+    data->indexCount = header->indexCount;
+    memcpy(data->min, header->min, sizeof(data->min));
+    memcpy(data->max, header->max, sizeof(data->max));
+    // the header is a multiple of 4 bytes and the vertices are floats, everything stays aligned
+    data->vertices = (MeshVertex*) (header + 1);
+    data->indices = (unsigned int*) (data->vertices + data->vertexCount);
+    data->mapping = mapping;
+    data->mappingSize = st.st_size;
+    return 0;
+}
+
+void mesh_data_free(struct MeshData *data) {
+    if(data->mapping != NULL) {
+        munmap(data->mapping, data->mappingSize);
+    } else {
+        free(data->vertices);
+        free(data->indices);
+    }
+    data->vertices = NULL;
+    data->indices = NULL;
+    data->mapping = NULL;
+    data->vertexCount = data->indexCount = 0;
+}
+
+float mesh_acmr(const unsigned int *indices, int indexCount, int vertexCount, int cacheSize) {
+    if(indexCount < 3) return 0;
+    // a vertex is still in the FIFO if less than cacheSize misses happened since it was added
+    int *addedAt = malloc(vertexCount * sizeof(int));
+    for(int i = 0; i < vertexCount; i++) addedAt[i] = -cacheSize - 1;
+    int misses = 0;
+    for(int i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        if(misses - addedAt[v] > cacheSize) {
+            addedAt[v] = misses;
+            misses++;
+        }
+    }
+    free(addedAt);
+    return (float) misses / (indexCount / 3);
+}
+
+// internal, how much emitting a triangle using a vertex is worth: more if it is recently in the cache,
+// more if few triangles are left using it (so that it can be done with instead of lingering)
+float vertexCacheScore(int cachePosition, int remainingTriangles) {
+    if(remainingTriangles == 0) return -1;
+    float score = 0;
+    if(cachePosition >= 0) {
+        // the vertices of the last triangle, whatever their order, are equally likely to be used again
+        if(cachePosition < 3) score = 0.75f;
+        else score = powf(1.0f - (float) (cachePosition - 3) / (MESH_OPTIMIZE_CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2.0f / sqrtf(remainingTriangles);
+}
+
+void mesh_optimize_vertex_cache(unsigned int *indices, int indexCount, int vertexCount) {
+    int triangleCount = indexCount / 3;
+    if(triangleCount == 0) return;
+    // triangles using each vertex, in one array (the ones of vertex v start at offsets[v])
+    int *remaining = calloc(vertexCount, sizeof(int));
+    int *offsets = malloc((vertexCount + 1) * sizeof(int));
+    int *vertexTriangles = malloc(indexCount * sizeof(int));
+    for(int i = 0; i < indexCount; i++) remaining[indices[i]]++;
+    offsets[0] = 0;
+    for(int v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+    int *filled = calloc(vertexCount, sizeof(int));
+    for(int i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        vertexTriangles[offsets[v] + filled[v]++] = i / 3;
+    }
+    free(filled);
+    int *cachePositions = malloc(vertexCount * sizeof(int));
+    float *vertexScores = malloc(vertexCount * sizeof(float));
+    for(int v = 0; v < vertexCount; v++) {
+        cachePositions[v] = -1;
+        vertexScores[v] = vertexCacheScore(-1, remaining[v]);
+    }
+    bool *emitted = calloc(triangleCount, sizeof(bool));
+    unsigned int *output = malloc(indexCount * sizeof(unsigned int));
+    // the cache, plus room for the 3 vertices pushed in front before the ones falling off are dropped
+    int cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    int cacheSize = 0;
+    int best = -1;
+    // where to look for a triangle when none of the cached vertices has any left
+    int nextUnemitted = 0;
+    for(int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if(best < 0) {
+            while(emitted[nextUnemitted]) nextUnemitted++;
+            best = nextUnemitted;
+        }
+        unsigned int *triangle = indices + best * 3;
+        memcpy(output + emittedCount * 3, triangle, 3 * sizeof(unsigned int));
+        emitted[best] = true;
+        // the triangle's vertices go in front, the rest of the cache keeps its order behind them
+        int newCache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+        int newSize = 0;
+        for(int i = 0; i < 3; i++) {
+            unsigned int v = triangle[i];
+            newCache[newSize++] = v;
+            // take the triangle out of the vertex's list (swapping it with the last remaining one)
+            int *list = vertexTriangles + offsets[v];
+            for(int j = 0; j < remaining[v]; j++) {
+                if(list[j] == best) {
+                    list[j] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+        for(int i = 0; i < cacheSize; i++) {
+            int v = cache[i];
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2]) newCache[newSize++] = v;
+        }
+        // update the scores of everything that moved in the cache (or fell off of it)
+        for(int i = 0; i < newSize; i++) {
+            int v = newCache[i];
+            cachePositions[v] = i < MESH_OPTIMIZE_CACHE_SIZE ? i : -1;
+            vertexScores[v] = vertexCacheScore(cachePositions[v], remaining[v]);
+        }
+        // and so of their triangles, the best of them is the next one (only triangles with a cached
+        // vertex are candidates, the others are left for when the cache has nothing left to offer)
+        best = -1;
+        float bestScore = -1;
+        for(int i = 0; i < newSize; i++) {
+            int v = newCache[i];
+            for(int j = 0; j < remaining[v]; j++) {
+                int t = vertexTriangles[offsets[v] + j];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                if(score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+        cacheSize = newSize < MESH_OPTIMIZE_CACHE_SIZE ? newSize : MESH_OPTIMIZE_CACHE_SIZE;
+        memcpy(cache, newCache, cacheSize * sizeof(int));
+    }
+    memcpy(indices, output, indexCount * sizeof(unsigned int));
+    free(output);
+    free(emitted);
+    free(vertexScores);
+    free(cachePositions);
+    free(vertexTriangles);
+    free(offsets);
+    free(remaining);
+}
+
+void mesh_optimize_vertex_fetch(MeshVertex *vertices, int vertexCount, unsigned int *indices, int indexCount) {
+    // new index of every vertex, given the first time it is used
+    int *remap = malloc(vertexCount * sizeof(int));
+    for(int v = 0; v < vertexCount; v++) remap[v] = -1;
+    int next = 0;
+    for(int i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        if(remap[v] < 0) remap[v] = next++;
+        indices[i] = remap[v];
+    }
+    for(int v = 0; v < vertexCount; v++) {
+        if(remap[v] < 0) remap[v] = next++;
+    }
+    MeshVertex *reordered = malloc(vertexCount * sizeof(MeshVertex));
+    for(int v = 0; v < vertexCount; v++) reordered[remap[v]] = vertices[v];
+    memcpy(vertices, reordered, vertexCount * sizeof(MeshVertex));
+    free(reordered);
+    free(remap);
+}
+
+void mesh_data_optimize(struct MeshData *data, float *acmrBefore, float *acmrAfter) {
+    if(acmrBefore != NULL) *acmrBefore = mesh_acmr(data->indices, data->indexCount, data->vertexCount, MESH_ACMR_CACHE_SIZE);
+    mesh_optimize_vertex_cache(data->indices, data->indexCount, data->vertexCount);
+    mesh_optimize_vertex_fetch(data->vertices, data->vertexCount, data->indices, data->indexCount);
+    if(acmrAfter != NULL) *acmrAfter = mesh_acmr(data->indices, data->indexCount, data->vertexCount, MESH_ACMR_CACHE_SIZE);
+}
+
+// internal, symmetric 4x4 matrix summing the squared distances to planes (a2 ab ac ad b2 bc bd c2 cd d2),
+// weighted by the area of the triangles they come from. the weight is kept to average the error
+typedef struct {
+    double q[10];
+    double weight;
+} Quadric;
+
+void addPlaneQuadric(Quadric *quadric, const double plane[4], double weight) {
+    int k = 0;
+    for(int i = 0; i < 4; i++) {
+        for(int j = i; j < 4; j++) quadric->q[k++] += plane[i] * plane[j] * weight;
+    }
+    quadric->weight += weight;
+}
+
+// internal, mean squared distance of p to the planes of the sum of a and b
+double quadricError(const Quadric *a, const Quadric *b, const float *p) {
+    double v[4] = {p[0], p[1], p[2], 1};
+    double error = 0;
+    int k = 0;
+    for(int i = 0; i < 4; i++) {
+        for(int j = i; j < 4; j++) {
+            double q = a->q[k] + b->q[k];
+            // the off diagonal terms appear twice in v^T Q v
+            error += q * v[i] * v[j] * (i == j ? 1 : 2);
+            k++;
+        }
+    }
+    double weight = a->weight + b->weight;
+    return weight > 0 ? fabs(error) / weight : 0;
+}
+
+// internal, a vertex moving onto one of its neighbours
+typedef struct {
+    unsigned int from;
+    unsigned int to;
+    double error;
+} Collapse;
+
+int compareCollapses(const void *a, const void *b) {
+    double ea = ((const Collapse*) a)->error, eb = ((const Collapse*) b)->error;
+    return (ea > eb) - (ea < eb);
+}
+
+// internal, non normalized normal of a triangle
+void triangleNormal(const float *a, const float *b, const float *c, double n[3]) {
+    double u[3], v[3];
+    for(int i = 0; i < 3; i++) {
+        u[i] = b[i] - a[i];
+        v[i] = c[i] - a[i];
+    }
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+#define POSITION(v) ((const float*) ((const char*) positions + (size_t) (v) * stride))
+
+int mesh_simplify(const float *positions, int stride, int vertexCount, const unsigned int *indices, int indexCount, int targetIndexCount, float maxError, unsigned int *out, float *error) {
+    memcpy(out, indices, indexCount * sizeof(unsigned int));
+    double maxSquaredError = (double) maxError * maxError;
+    double reached = 0;
+    // the quadrics of the original surface, merged as vertices collapse onto others
+    Quadric *quadrics = calloc(vertexCount, sizeof(Quadric));
+    for(int t = 0; t < indexCount; t += 3) {
+        double n[3];
+        triangleNormal(POSITION(out[t]), POSITION(out[t + 1]), POSITION(out[t + 2]), n);
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if(length == 0) continue;
+        const float *p = POSITION(out[t]);
+        double plane[4] = {n[0] / length, n[1] / length, n[2] / length, 0};
+        plane[3] = -(plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2]);
+        // the length of the cross product is twice the area
+        for(int i = 0; i < 3; i++) addPlaneQuadric(&quadrics[out[t + i]], plane, length * 0.5);
+    }
+    int *offsets = malloc((vertexCount + 1) * sizeof(int));
+    int *adjacency = malloc(indexCount * sizeof(int));
+    bool *locked = malloc(vertexCount * sizeof(bool));
+    bool *touched = malloc(vertexCount * sizeof(bool));
+    unsigned int *remap = malloc(vertexCount * sizeof(unsigned int));
+    Collapse *collapses = malloc(indexCount * sizeof(Collapse));
+    // done in passes: every pass collapses the cheapest edges not touching each other, then rebuilds the triangles
+    while(indexCount > targetIndexCount) {
+        // triangles around every vertex
+        memset(offsets, 0, (vertexCount + 1) * sizeof(int));
+        for(int i = 0; i < indexCount; i++) offsets[out[i] + 1]++;
+        for(int v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+        for(int i = 0; i < indexCount; i++) adjacency[offsets[out[i]]++] = i / 3;
+        // offsets were moved to the end of every list while filling them
+        for(int v = vertexCount; v > 0; v--) offsets[v] = offsets[v - 1];
+        offsets[0] = 0;
+        // a vertex is on a border if one of its edges isn't shared, in the opposite direction, by another triangle
+        for(int v = 0; v < vertexCount; v++) {
+            locked[v] = false;
+            touched[v] = false;
+            remap[v] = v;
+        }
+        for(int v = 0; v < vertexCount; v++) {
+            for(int i = offsets[v]; i < offsets[v + 1] && !locked[v]; i++) {
+                const unsigned int *tri = out + adjacency[i] * 3;
+                int corner = tri[0] == v ? 0 : tri[1] == v ? 1 : 2;
+                unsigned int next = tri[(corner + 1) % 3];
+                bool shared = false;
+                for(int j = offsets[v]; j < offsets[v + 1] && !shared; j++) {
+                    const unsigned int *other = out + adjacency[j] * 3;
+                    for(int k = 0; k < 3; k++) shared |= other[k] == next && other[(k + 1) % 3] == v;
+                }
+                locked[v] = !shared;
+            }
+        }
+        int collapseCount = 0;
+        for(int i = 0; i < indexCount; i++) {
+            unsigned int from = out[i], to = out[i / 3 * 3 + (i + 1) % 3];
+            if(locked[from]) continue;
+            Collapse c = {from, to, quadricError(&quadrics[from], &quadrics[to], POSITION(to))};
+            collapses[collapseCount++] = c;
+        }
+        qsort(collapses, collapseCount, sizeof(Collapse), compareCollapses);
+        // a collapse removes 2 triangles, don't go (much) under the target
+        int allowed = (indexCount - targetIndexCount) / 6 + 1;
+        int collapsed = 0;
+        for(int c = 0; c < collapseCount && collapsed < allowed; c++) {
+            Collapse *collapse = &collapses[c];
+            if(collapse->error > maxSquaredError) break;
+            if(touched[collapse->from] || touched[collapse->to]) continue;
+            // the triangles around from, that don't disappear, mustn't flip when it moves
+            bool flips = false;
+            for(int i = offsets[collapse->from]; i < offsets[collapse->from + 1] && !flips; i++) {
+                const unsigned int *tri = out + adjacency[i] * 3;
+                if(tri[0] == collapse->to || tri[1] == collapse->to || tri[2] == collapse->to) continue;
+                const float *before[3], *after[3];
+                for(int k = 0; k < 3; k++) {
+                    before[k] = POSITION(tri[k]);
+                    after[k] = tri[k] == collapse->from ? POSITION(collapse->to) : before[k];
+                }
+                double n0[3], n1[3];
+                triangleNormal(before[0], before[1], before[2], n0);
+                triangleNormal(after[0], after[1], after[2], n1);
+                flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0;
+            }
+            if(flips) continue;
+            remap[collapse->from] = collapse->to;
+            for(int k = 0; k < 10; k++) quadrics[collapse->to].q[k] += quadrics[collapse->from].q[k];
+            quadrics[collapse->to].weight += quadrics[collapse->from].weight;
+            // every vertex around from is left alone for this pass, the checks above assumed they don't move
+            for(int i = offsets[collapse->from]; i < offsets[collapse->from + 1]; i++) {
+                const unsigned int *tri = out + adjacency[i] * 3;
+                for(int k = 0; k < 3; k++) touched[tri[k]] = true;
+            }
+            if(collapse->error > reached) reached = collapse->error;
+            collapsed++;
+        }
+        if(collapsed == 0) break;
+        // rebuild the triangles, dropping the ones that became degenerate
+        int kept = 0;
+        for(int t = 0; t < indexCount; t += 3) {
+            unsigned int a = remap[out[t]], b = remap[out[t + 1]], c = remap[out[t + 2]];
+            if(a == b || b == c || a == c) continue;
+            out[kept++] = a;
+            out[kept++] = b;
+            out[kept++] = c;
+        }
+        indexCount = kept;
+    }
+    free(collapses);
+    free(remap);
+    free(touched);
+    free(locked);
+    free(adjacency);
+    free(offsets);
+    free(quadrics);
+    if(error != NULL) *error = sqrt(reached);
+    return indexCount;
+}
+#undef POSITION
@@ -0,0 +1,76 @@
+#ifndef _MESHES_H
+#define _MESHES_H
+#include <stddef.h>
+
+// "GLHM" read as a little endian int
+#define MESH_FILE_MAGIC 0x4d484c47
+#define MESH_FILE_VERSION 1
+
+// one vertex, the same interleaved layout as what the GPU reads (GlhMeshVertex)
+typedef struct {
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+} MeshVertex;
+
+// start of a mesh file, directly followed by vertexCount MeshVertex then indexCount unsigned ints.
+// everything is in the byte order of the machine that wrote it, the file is meant to be mapped as is
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    float min[3];
+    float max[3];
+} MeshFileHeader;
+
+// indexed triangles ready to be uploaded, 3 indices per triangle
+struct MeshData {
+    MeshVertex *vertices;
+    unsigned int *indices;
+    int vertexCount;
+    int indexCount;
+    // bounds of the positions
+    float min[3];
+    float max[3];
+    // when loaded by mesh_data_map, vertices and indices point into this read only mapping of the
+    // file instead of being allocated. NULL otherwise
+    void *mapping;
+    size_t mappingSize;
+};
+
+// parse a Wavefront OBJ file (v, vt, vn and f lines, polygons are triangulated as fans), every distinct
+// position / texcoord / normal triple becoming a single vertex. returns 0 on success, -1 otherwise
+int mesh_data_import_obj(struct MeshData *data, const char *filename);
+// write data as a mesh file, returns 0 on success, -1 otherwise
+int mesh_data_write(const struct MeshData *data, const char *filename);
+// map a mesh file written by mesh_data_write, nothing is parsed or copied (the indices are only checked to be
+// whole triangles of existing vertices). returns 0 on success, -1 otherwise
+int mesh_data_map(struct MeshData *data, const char *filename);
+void mesh_data_free(struct MeshData *data);
+
+// entries of the simulated post transform cache the triangles are ordered for
+#define MESH_OPTIMIZE_CACHE_SIZE 32
+// entries of the FIFO cache mesh_acmr simulates, roughly what current GPUs behave like
+#define MESH_ACMR_CACHE_SIZE 16
+
+// average cache miss ratio: vertices transformed per triangle with a FIFO cache of cacheSize vertices.
+// 3 is the worst, around 0.6 is about the best a regular grid gets
+float mesh_acmr(const unsigned int *indices, int indexCount, int vertexCount, int cacheSize);
+// reorder the triangles so consecutive ones share vertices, for the post transform cache (Forsyth's linear speed algorithm)
+void mesh_optimize_vertex_cache(unsigned int *indices, int indexCount, int vertexCount);
+// reorder the vertices in the order the triangles first use them (remapping indices), for fetch locality.
+// unused vertices end up last
+void mesh_optimize_vertex_fetch(MeshVertex *vertices, int vertexCount, unsigned int *indices, int indexCount);
+// both of the above, in that order. data can't be mapped. the acmr before and after are written to
+// acmrBefore and acmrAfter if they aren't NULL
+void mesh_data_optimize(struct MeshData *data, float *acmrBefore, float *acmrAfter);
+
+// collapse edges (moving a vertex onto a neighbour, so no vertex is created) until at most targetIndexCount
+// indices are left, or until any further collapse would move the surface by more than maxError (quadric error,
+// as a distance in the same units as the positions). vertices on borders (and so on uv / normal seams, where
+// vertices are split) never move. positions are read every stride bytes.
+// writes the indices of the simplified triangles (of the same vertices) to out, which must hold indexCount indices,
+// returns how many there are, and the error reached in *error (can be NULL)
+int mesh_simplify(const float *positions, int stride, int vertexCount, const unsigned int *indices, int indexCount, int targetIndexCount, float maxError, unsigned int *out, float *error);
+#endif
@@ -0,0 +1,104 @@
+#include "shadercache.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+unsigned long long shader_cache_hash(unsigned long long hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+unsigned long long shader_cache_hash_string(unsigned long long hash, const char *string) {
+    return shader_cache_hash(hash, string, strlen(string) + 1);
+}
+
+// internal, path of the entry of key, to be freed
+char* shaderCachePath(const char *directory, unsigned long long key, const char *suffix) {
+    // a separator, 16 hex digits and ".bin"
+    char *path = malloc(strlen(directory) + 1 + 16 + 4 + strlen(suffix) + 1);
+    sprintf(path, "%s/%016llx.bin%s", directory, key, suffix);
+    return path;
+}
+
+int shader_cache_load(const char *directory, unsigned long long key, unsigned int *format, void **binary, int *length) {
+    char *path = shaderCachePath(directory, key, "");
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) {
+        free(path);
+        return -1;
+    }
+    ShaderCacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SHADER_CACHE_MAGIC
+        && header.version == SHADER_CACHE_VERSION && header.key == key && header.length > 0;
+    *binary = valid ? malloc(header.length) : NULL;
+    valid = valid && fread(*binary, 1, header.length, file) == header.length;
+    fclose(file);
+    if(!valid) {
+        printf("ERROR: shader_cache_load, %s is not a valid cache entry\n", path);
+        free(*binary);
+        *binary = NULL;
+        free(path);
+        return -1;
+    }
+    free(path);
+    *format = header.format;
+    *length = header.length;
+    return 0;
+}
+
+int shader_cache_store(const char *directory, unsigned long long key, unsigned int format, const void *binary, int length) {
+    if(mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("ERROR: shader_cache_store, unable to create %s\n", directory);
+        return -1;
+    }
+    char *path = shaderCachePath(directory, key, "");
+    char *temporary = shaderCachePath(directory, key, ".tmp");
+    FILE *file = fopen(temporary, "wb");
+    if(file == NULL) {
+        printf("ERROR: shader_cache_store, unable to open %s\n", temporary);
+        free(temporary);
+        free(path);
+        return -1;
+    }
+    ShaderCacheHeader header = {SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, key, format, length};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary, 1, length, file) == (size_t) length;
+    if(fclose(file) != 0 || !written || rename(temporary, path) != 0) {
+        printf("ERROR: shader_cache_store, unable to write %s\n", path);
+        remove(temporary);
+        free(temporary);
+        free(path);
+        return -1;
+    }
+    free(temporary);
+    free(path);
+    return 0;
+}
+
+char* shader_source_with_defines(const char *source, char *defines[], int definesCount) {
+    // the defines go after the first line if it is the #version one, it has to come first
+    size_t split = 0;
+    int nextLine = 1;
+    if(strncmp(source, "#version", 8) == 0) {
+        const char *end = strchr(source, '\n');
+        split = end != NULL ? (size_t) (end - source) + 1 : strlen(source);
+        nextLine = 2;
+    }
+    size_t size = strlen(source) + 1 + 32;
+    for(int i = 0; i < definesCount; i++) size += strlen(defines[i]) + 9;
+    char *result = malloc(size);
+    memcpy(result, source, split);
+    char *out = result + split;
+    // a #version line without a newline (nothing else in the file) still needs one before the defines
+    if(split > 0 && source[split - 1] != '\n') *out++ = '\n';
+    for(int i = 0; i < definesCount; i++) out += sprintf(out, "#define %s\n", defines[i]);
+    out += sprintf(out, "#line %i\n", nextLine);
+    strcpy(out, source + split);
+    return result;
+}
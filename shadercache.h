@@ -0,0 +1,36 @@
+#ifndef _SHADERCACHE_H
+#define _SHADERCACHE_H
+#include <stddef.h>
+
+// "GLHC" read as a little endian int
+#define SHADER_CACHE_MAGIC 0x43484c47
+#define SHADER_CACHE_VERSION 1
+// starting value of shader_cache_hash (FNV-1a 64 bits offset basis)
+#define SHADER_CACHE_HASH_SEED 0xcbf29ce484222325ULL
+
+// start of a cache entry, directly followed by length bytes of program binary.
+// entries are named after their key, the key is repeated in case a file was renamed or truncated
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long key;
+    // binary format given by the driver (glGetProgramBinary), handed back to glProgramBinary
+    unsigned int format;
+    unsigned int length;
+} ShaderCacheHeader;
+
+// continue a FNV-1a 64 bits hash with size bytes of data
+unsigned long long shader_cache_hash(unsigned long long hash, const void *data, size_t size);
+// same with a string, its terminating 0 included so that "ab" then "c" doesn't hash like "a" then "bc"
+unsigned long long shader_cache_hash_string(unsigned long long hash, const char *string);
+// read the entry of key from directory, *binary being malloc'd. returns 0 on success, -1 if there is
+// no entry (silently, that is just a cache miss) or it is invalid
+int shader_cache_load(const char *directory, unsigned long long key, unsigned int *format, void **binary, int *length);
+// write the entry of key to directory (created if needed), written to a temporary file then renamed
+// so a concurrent reader never sees half of it. returns 0 on success, -1 otherwise
+int shader_cache_store(const char *directory, unsigned long long key, unsigned int format, const void *binary, int length);
+// malloc'd copy of a GLSL source with a `#define <define>` line for every defines (like "SHADOWS" or "LIGHTS 4")
+// right after its #version line (at the very start if there isn't one), followed by a #line directive so
+// compilation errors still point at the lines of the original file
+char* shader_source_with_defines(const char *source, char *defines[], int definesCount);
+#endif
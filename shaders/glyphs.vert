@@ -1,6 +1,13 @@
 #version 420
 
-uniform mat4 MVP;
+// shared by every program, uploaded once per frame (see GlhCameraBlock)
+layout(std140) uniform GlhCamera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+uniform mat4 model;
 
 out vec2 texCoord;
 out vec4 color;
@@ -13,5 +20,5 @@ layout(location = 3) in vec4 vColor;
 void main() {
     texCoord = vTexCoord;
     color = vColor;
-    gl_Position = MVP * vec4(vPos, 1.0);;
+    gl_Position = viewProjection * model * vec4(vPos, 1.0);
 }
@@ -0,0 +1,21 @@
+#version 420
+
+// shared by every program, uploaded once per frame (see GlhCameraBlock)
+layout(std140) uniform GlhCamera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+
+out vec2 texCoord;
+
+in vec3 vPos;
+in vec2 vTexCoord;
+// per instance, one model matrix per object
+in mat4 iModel;
+
+void main() {
+    texCoord = vTexCoord;
+    gl_Position = viewProjection * iModel * vec4(vPos, 1.0);
+}
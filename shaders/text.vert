@@ -1,6 +1,13 @@
 #version 420
 
-uniform mat4 MVP; 
+// shared by every program, uploaded once per frame (see GlhCameraBlock)
+layout(std140) uniform GlhCamera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+uniform mat4 model;
 
 layout(location = 0) out vec4 opos;
 layout(location = 1) out vec4 color;
@@ -10,7 +17,7 @@ layout(location = 1) in vec3 normals;
 layout(location = 2) in vec4 vColor;
 
 void main() {
-    vec4 pos = MVP * vec4(vPos, 1.0);
+    vec4 pos = viewProjection * model * vec4(vPos, 1.0);
     opos = pos;
     color = vColor;
     gl_Position = pos;
@@ -0,0 +1,14 @@
+#version 420
+
+in vec2 texCoord;
+in vec4 color;
+
+out vec4 FragColor;
+
+uniform sampler2D uTexture;
+
+void main() {
+    // backgrounds have negative texCoords, they cover their whole quad
+    float coverage = texCoord.x < 0 ? 1.0 : texture(uTexture, texCoord).x;
+    FragColor = vec4(color.xyz, color.w * coverage);
+}
@@ -0,0 +1,23 @@
+#version 420
+
+// shared by every program, uploaded once per frame (see GlhCameraBlock)
+layout(std140) uniform GlhCamera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+
+out vec2 texCoord;
+out vec4 color;
+
+// already in world space, transformed when batched
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec4 vColor;
+layout(location = 2) in vec2 vTexCoord;
+
+void main() {
+    texCoord = vTexCoord;
+    color = vColor;
+    gl_Position = viewProjection * vec4(vPos, 1.0);
+}
@@ -3,25 +3,31 @@
 #include <stdio.h>
 #include <string.h>
 
+// internal, the vector may have moved its data after a push so top is recomputed from it
+void updateStackTop(struct Stack *stk) {
+    stk->top = (char*)stk->vec.data + (stk->vec.size - 1) * (int)stk->vec.data_size;
+}
+
 void stack_init(struct Stack *stk, size_t dataSize) {
     vector_init(&stk->vec, 5, dataSize);
-    stk->top = stk->vec.data - dataSize;
+    updateStackTop(stk);
 }
 
 void stack_push(struct Stack *stk, void* data) {
     vector_push(&stk->vec, data);
-    stk->top += stk->vec.data_size;
+    updateStackTop(stk);
 }
 
 void stack_pop(struct Stack *stk, void* data) {
     vector_pop(&stk->vec, data);
-    stk->top -= stk->vec.data_size;
+    updateStackTop(stk);
 }
 
 void stack_move_to_top(struct Stack *stk, int index) {
     void* data = vector_get_pointer_to(stk->vec, index);
     vector_push(&stk->vec, data);
     vector_splice(&stk->vec, index, 1, NULL);
+    updateStackTop(stk);
 }
 
 bool stack_is_empty(struct Stack stk) {
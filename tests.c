@@ -5,8 +5,16 @@
 #include "vector.h"
 #include "events.h"
 #include "maps.h"
+#include "intern.h"
+#include "transforms.h"
+#include "bvh.h"
+#include "meshes.h"
+#include "shadercache.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
 
 void eventsCallback1(void* arg) {
     int a = *(int*)arg;
@@ -18,6 +26,71 @@ void eventsCallback2(void* arg) {
     printf("event callback 2 called, arg: %i\n", a);
 }
 
+void eventsCallback3(void* arg) {
+    int a = *(int*)arg;
+    printf("event callback 3 called, arg: %i\n", a);
+}
+
+struct EventBroadcaster* unsubscribingEvents;
+int unsubscribedId;
+int unsubscribingCalls = 0;
+
+void unsubscribingCallback(void* arg) {
+    unsubscribingCalls++;
+    printf("unsubscribing callback called, arg: %i\n", *(int*)arg);
+    events_unsubscribe(unsubscribingEvents, unsubscribedId);
+}
+
+struct EventQueue queue;
+int queueEventId;
+int queuedSum = 0;
+int queuedCount = 0;
+
+void queuedCallback(void* arg) {
+    queuedSum += *(int*)arg;
+    queuedCount++;
+}
+
+// keeps the smallest value of the coalesced events
+void queuedMerge(void* latest, void* older) {
+    if(*(int*)older < *(int*)latest) *(int*)latest = *(int*)older;
+}
+
+void* queueProducer(void* arg) {
+    for(int i = 1; i <= 1000; i++) {
+        while(!event_queue_post(&queue, queueEventId, &i, sizeof(int)));
+    }
+    return NULL;
+}
+
+// reference for transform_compose, the chain of matrix products it replaces
+void referenceTransform(const float t[3], const float s[3], const float r[3], const float o[3], float out[16]) {
+    float m[16], tmp[16];
+    float steps[7][16];
+    for(int k = 0; k < 7; k++) {
+        for(int i = 0; i < 16; i++) steps[k][i] = i % 5 == 0;
+    }
+    steps[0][12] = t[0]; steps[0][13] = t[1]; steps[0][14] = t[2];
+    steps[1][0] = s[0]; steps[1][5] = s[1]; steps[1][10] = s[2];
+    steps[2][12] = o[0]; steps[2][13] = o[1]; steps[2][14] = o[2];
+    steps[3][5] = cosf(r[0]); steps[3][6] = sinf(r[0]); steps[3][9] = -sinf(r[0]); steps[3][10] = cosf(r[0]);
+    steps[4][0] = cosf(r[1]); steps[4][2] = -sinf(r[1]); steps[4][8] = sinf(r[1]); steps[4][10] = cosf(r[1]);
+    steps[5][0] = cosf(r[2]); steps[5][1] = sinf(r[2]); steps[5][4] = -sinf(r[2]); steps[5][5] = cosf(r[2]);
+    steps[6][12] = -o[0]; steps[6][13] = -o[1]; steps[6][14] = -o[2];
+    memcpy(m, steps[0], sizeof(m));
+    for(int k = 1; k < 7; k++) {
+        transform_multiply(m, steps[k], tmp);
+        memcpy(m, tmp, sizeof(m));
+    }
+    memcpy(out, m, sizeof(m));
+}
+
+float matrixDifference(const float* a, const float* b) {
+    float d = 0;
+    for(int i = 0; i < 16; i++) d = fmaxf(d, fabsf(a[i] - b[i]));
+    return d;
+}
+
 int main() {
     printf("\ntesting vector: basic int\n\n");
     printf("1: initializing vector with initial allocation 5\n");
@@ -85,6 +158,64 @@ int main() {
     printf("\n\n");
     printf("freeing vector\n");
     vector_free(v);
+    printf("\ntesting typed vector: Vector_int\n\n");
+    printf("1: initializing Vector_int with initial allocation 0 and pushing 0 to 9\n");
+    Vector_int tv;
+    vector_int_init(&tv, 0);
+    for(int i = 0; i < 10; i++) {
+        vector_int_push(&tv, i);
+    }
+    printf("vector size: %i, vector allocated: %i\n", tv.size, tv.allocated);
+    printf("vector state: [");
+    for(int i = 0; i < tv.size; i++) printf(i == 0 ? "%i" : ", %i", vector_int_get(&tv, i));
+    printf("]\n\n");
+    printf("2: testing push_array\nappending 3 elements 100 times\n");
+    int chunk[3] = {1, 2, 3};
+    for(int i = 0; i < 100; i++) {
+        vector_int_push_array(&tv, chunk, 3);
+    }
+    printf("vector size: %i (expected 310), vector allocated: %i\n\n", tv.size, tv.allocated);
+    printf("3: testing splice and set\nsplicing from index 10 until the end, then setting index 0 to 42\n");
+    vector_int_splice(&tv, 10, -1);
+    vector_int_set(&tv, 42, 0);
+    printf("vector size: %i\nvector state: [", tv.size);
+    for(int i = 0; i < tv.size; i++) printf(i == 0 ? "%i" : ", %i", vector_int_get(&tv, i));
+    printf("]\n\n");
+    printf("freeing typed vector\n");
+    vector_int_free(tv);
+    printf("\ntesting small vector: inline storage\n\n");
+    printf("1: initializing SmallVector of ints (inline capacity %i)\n", (int)(SMALL_VECTOR_INLINE_BYTES / sizeof(int)));
+    SmallVector sv;
+    small_vector_init(&sv, sizeof(int));
+    for(int i = 0; i < 5; i++) {
+        small_vector_push(&sv, &i);
+    }
+    printf("pushed 5 values, size: %i, on heap: %s\n", sv.size, sv.heap == NULL ? "no" : "yes");
+    printf("2: pushing past the inline capacity\n");
+    for(int i = 5; i < 40; i++) {
+        small_vector_push(&sv, &i);
+    }
+    printf("size: %i, allocated: %i, on heap: %s\n", sv.size, sv.allocated, sv.heap == NULL ? "no" : "yes");
+    printf("values kept when spilling (expects 0 4 31 39): %i %i %i %i\n",
+        vector_get(small_vector_data(&sv), 0, int), vector_get(small_vector_data(&sv), 4, int),
+        vector_get(small_vector_data(&sv), 31, int), vector_get(small_vector_data(&sv), 39, int));
+    printf("3: splicing from index 1 until the end\n");
+    small_vector_splice(&sv, 1, -1, NULL);
+    printf("size: %i, first value: %i\n\n", sv.size, vector_get(small_vector_data(&sv), 0, int));
+    printf("freeing small vector\n");
+    small_vector_free(&sv);
+    printf("\ntesting string interning\n\n");
+    printf("1: interning the same content from two different buffers\n");
+    char bufa[16];
+    char bufb[16];
+    strcpy(bufa, "interned");
+    strcpy(bufb, "interned");
+    char* ia = intern_string(bufa);
+    char* ib = intern_string(bufb);
+    printf("same pointer: %s, copied out of the buffers: %s\n", ia == ib ? "yes" : "no", ia != bufa && ia != bufb ? "yes" : "no");
+    printf("2: overwriting the buffer, interned string: \"%s\"\n", (strcpy(bufa, "changed"), ia));
+    printf("3: finding strings without interning them\nfind \"interned\": %s, find \"never\": %s\n",
+        find_interned_string("interned") == ia ? "found" : "missing", find_interned_string("never") == NULL ? "missing" : "found");
     printf("\ntesting events\ninitializing EventBroadcaster\n\n");
     struct EventBroadcaster ev;
     events_init(&ev);
@@ -92,7 +223,7 @@ int main() {
     events_subscribe(&ev, "event1", eventsCallback1, NULL);
     int e2id;
     events_subscribe(&ev, "event2", eventsCallback2, &e2id);
-    printf("EventBroadcaster's subscribers size: %i\n\n", ev.subscribers.size);
+    printf("EventBroadcaster's subscribers size: %i\n\n", ev.subscriberCount);
     printf("2: testing events_broadcast\nbroadcasting \"event1\" (arg = 12) and \"event2\" (arg = 6) \n");
     int evl = 12;
     events_broadcast(&ev, "event1", &evl);
@@ -100,12 +231,70 @@ int main() {
     events_broadcast(&ev, "event2", &evl);
     printf("\n\n3: testing events_unsubscribe\nunsubscribing 2nd subscribed event\n");
     events_unsubscribe(&ev, e2id);
-    printf("new EventBroadcaster's subscribers size: %i\n\n", ev.subscribers.size);
+    printf("new EventBroadcaster's subscribers size: %i\n\n", ev.subscriberCount);
     printf("4: retesting events_broadcast after unsubscribing\nbroadcasting \"event1\" (arg = 12) and \"event2\" (arg = 6) \n");
     evl = 12;
     events_broadcast(&ev, "event1", &evl);
     evl = 6;
     events_broadcast(&ev, "event2", &evl);
+    printf("\n5: broadcasting \"event1\" from a different buffer than the one it was subscribed with (arg = 3)\n");
+    char evname[8];
+    strcpy(evname, "event1");
+    evl = 3;
+    events_broadcast(&ev, evname, &evl);
+    printf("\n6: testing event ids and swap removal\nsubscribing callbacks 2 and 3 to \"event1\" by id, then unsubscribing the first one (twice)\n");
+    int e1 = events_register(&ev, "event1");
+    int e3id;
+    events_subscribe_id(&ev, e1, eventsCallback2, &e2id);
+    events_subscribe_id(&ev, e1, eventsCallback3, &e3id);
+    events_unsubscribe(&ev, 0);
+    events_unsubscribe(&ev, 0);
+    printf("\"event1\" id: %i, subscribers size: %i (expected 2)\nbroadcasting \"event1\" by id (arg = 9), expects callbacks 2 and 3\n", e1, ev.subscriberCount);
+    evl = 9;
+    events_broadcast_id(&ev, e1, &evl);
+    printf("unsubscribing callback 3 then broadcasting again, expects callback 2\n");
+    events_unsubscribe(&ev, e3id);
+    events_broadcast_id(&ev, e1, &evl);
+    printf("\n7: testing unsubscribing from a callback\nsubscribing one unsubscribing the last during the broadcast, then callbacks 3 and 1\n");
+    int e4 = events_register(&ev, "event4");
+    unsubscribingEvents = &ev;
+    events_subscribe_id(&ev, e4, unsubscribingCallback, NULL);
+    events_subscribe_id(&ev, e4, eventsCallback3, NULL);
+    events_subscribe_id(&ev, e4, eventsCallback1, &unsubscribedId);
+    evl = 4;
+    printf("broadcasting \"event4\" (arg = 4), expects the unsubscribing callback then callback 3\n");
+    events_broadcast_id(&ev, e4, &evl);
+    printf("broadcasting again, expects the same\n");
+    events_broadcast_id(&ev, e4, &evl);
+    printf("unsubscribing callback calls: %i (expected 2), subscribers size: %i (expected 3)\n", unsubscribingCalls, ev.subscriberCount);
+    printf("\n8: testing the event queue\nposting 1000 events (1 to 1000) from 4 threads each, dispatching once they are done\n");
+    event_queue_init(&queue, &ev, 4096);
+    queueEventId = events_register(&ev, "queued");
+    events_subscribe_id(&ev, queueEventId, queuedCallback, NULL);
+    pthread_t producers[4];
+    for(int i = 0; i < 4; i++) pthread_create(&producers[i], NULL, queueProducer, NULL);
+    for(int i = 0; i < 4; i++) pthread_join(producers[i], NULL);
+    int dispatched = event_queue_dispatch(&queue);
+    printf("dispatched: %i (expected 4000), callbacks: %i, sum: %i (expected 2002000)\n", dispatched, queuedCount, queuedSum);
+    printf("posting 1, 2, 3 with coalescing on, then dispatching\n");
+    event_queue_set_coalescing(&queue, queueEventId, true, NULL);
+    for(int i = 1; i <= 3; i++) event_queue_post(&queue, queueEventId, &i, sizeof(int));
+    queuedSum = 0;
+    dispatched = event_queue_dispatch(&queue);
+    printf("dispatched: %i (expected 1), value: %i (expected 3)\n", dispatched, queuedSum);
+    printf("posting 5, 4, 6 with a merge keeping the smallest value, then dispatching\n");
+    event_queue_set_coalescing(&queue, queueEventId, true, queuedMerge);
+    int mergedValues[3] = {5, 4, 6};
+    for(int i = 0; i < 3; i++) event_queue_post(&queue, queueEventId, &mergedValues[i], sizeof(int));
+    queuedSum = 0;
+    dispatched = event_queue_dispatch(&queue);
+    printf("dispatched: %i (expected 1), value: %i (expected 4)\n", dispatched, queuedSum);
+    int unknown = 7;
+    printf("posting to unknown event ids then dispatching\n");
+    event_queue_post(&queue, -1, &unknown, sizeof(int));
+    event_queue_post(&queue, ev.channels.size, &unknown, sizeof(int));
+    printf("dispatched: %i (expected 0)\n", event_queue_dispatch(&queue));
+    event_queue_free(&queue);
     printf("\nfreeing events...\n");
     events_free(&ev);
     printf("\nTesting maps\ninitializing map\n\n");
@@ -132,6 +321,386 @@ int main() {
     printf("map: ");
     map_print(map, int, "%i");
     printf("\n\n");
+    printf("4: testing many keys\nsetting 1000 keys, then deleting every even one\n");
+    static char keys[1000][8];
+    for(int i = 0; i < 1000; i++) {
+        sprintf(keys[i], "k%i", i);
+        map_set(&map, keys[i], &i);
+    }
+    for(int i = 0; i < 1000; i += 2) {
+        map_delete(&map, keys[i]);
+    }
+    int missing = 0;
+    int wrong = 0;
+    for(int i = 0; i < 1000; i++) {
+        if(map_has(&map, keys[i]) != (i % 2 == 1)) missing++;
+        if(i % 2 == 1) {
+            map_get(&map, keys[i], &mpv);
+            if(mpv != i) wrong++;
+        }
+    }
+    printf("map size: %i (expected 500), wrong presence: %i, wrong values: %i\n\n", map.size, missing, wrong);
+    printf("5: testing map_freeze\nfreezing the 500 remaining keys\n");
+    FrozenMap frozen;
+    printf("result: %i (expected 0)\n", map_freeze(&map, &frozen));
+    missing = 0;
+    wrong = 0;
+    for(int i = 0; i < 1000; i++) {
+        if(frozen_map_has(&frozen, keys[i]) != (i % 2 == 1)) missing++;
+        if(i % 2 == 1) {
+            frozen_map_get(&frozen, keys[i], &mpv);
+            if(mpv != i) wrong++;
+        }
+    }
+    printf("frozen map size: %i (expected 500), wrong presence: %i, wrong values: %i\n\n", frozen.size, missing, wrong);
+    frozen_map_free(&frozen);
+    printf("6: testing keys not outliving the map\nsetting a key from a buffer then overwriting the buffer\n");
+    char keybuf[8];
+    strcpy(keybuf, "tmpkey");
+    mv = 7;
+    map_set(&map, keybuf, &mv);
+    strcpy(keybuf, "garbage");
+    map_get(&map, "tmpkey", &mpv);
+    printf("found value: %i (expected 7)\n\n", mpv);
+    printf("7: testing interned keys and map_get_pointer\n");
+    char* internedKey = intern_string("interned");
+    mv = 11;
+    map_set_interned(&map, internedKey, &mv);
+    int* valuePointer = map_get_pointer(&map, "interned");
+    map_get_interned(&map, internedKey, &mpv);
+    printf("through the string: %i, through the interned key: %i (expected 11), has: %i, unset pointer: %s\n\n",
+        valuePointer != NULL ? *valuePointer : -1, mpv, map_has_interned(&map, internedKey), map_get_pointer(&map, "unset") == NULL ? "NULL" : "WRONG");
     printf("freeing map...\n");
     map_free(&map);
+
+    printf("\ntesting transform store\n1: composing 37 elements and comparing with the chained products\n");
+    struct TransformStore store;
+    transform_store_init(&store);
+    float tr[37][4][3];
+    for(int i = 0; i < 37; i++) {
+        transform_store_add(&store);
+        for(int c = 0; c < 3; c++) {
+            tr[i][0][c] = i * 0.3 - c;
+            tr[i][1][c] = 1 + (i % 5) * 0.25 + c * 0.1;
+            tr[i][2][c] = i * 0.17 + c * 0.9;
+            tr[i][3][c] = (i % 3) - c * 0.5;
+        }
+        transform_store_set(&store, i, tr[i][0], tr[i][1], tr[i][2], tr[i][3]);
+    }
+    transform_store_compose(&store);
+    float maxError = 0;
+    for(int i = 0; i < 37; i++) {
+        float expected[16];
+        referenceTransform(tr[i][0], tr[i][1], tr[i][2], tr[i][3], expected);
+        maxError = fmaxf(maxError, matrixDifference(transform_store_model(&store, i), expected));
+        float single[16];
+        transform_compose(tr[i][0], tr[i][1], tr[i][2], tr[i][3], single);
+        maxError = fmaxf(maxError, matrixDifference(single, expected));
+    }
+    printf("max difference: %s\n", maxError < 1e-4 ? "< 1e-4 (ok)" : "TOO BIG");
+    transform_store_clear_dirty(&store);
+    printf("\n2: dirty tracking\nsetting the same transforms on element 5, then moving element 20\n");
+    bool same = transform_store_set(&store, 5, tr[5][0], tr[5][1], tr[5][2], tr[5][3]);
+    tr[20][0][1] += 1;
+    bool moved = transform_store_set(&store, 20, tr[20][0], tr[20][1], tr[20][2], tr[20][3]);
+    int dirtyCount = 0;
+    for(int i = 0; i < 37; i++) dirtyCount += transform_store_is_dirty(&store, i);
+    printf("changed: %i %i (expected 0 1), dirty elements: %i (expected 1)\n", same, moved, dirtyCount);
+    transform_store_compose(&store);
+    float expected[16];
+    referenceTransform(tr[20][0], tr[20][1], tr[20][2], tr[20][3], expected);
+    printf("model of element 20 after update: %s\n", matrixDifference(transform_store_model(&store, 20), expected) < 1e-4 ? "ok" : "WRONG");
+    transform_store_free(&store);
+    printf("\n3: hierarchy\nadding root 0, child of 0, root, child of 0, child of the first child\n");
+    transform_store_init(&store);
+    int root = transform_store_add(&store);
+    int childA = transform_store_insert_child(&store, root);
+    int otherRoot = transform_store_add(&store);
+    int childB = transform_store_insert_child(&store, root);
+    // childB was inserted before otherRoot, which moved
+    otherRoot++;
+    int grandChild = transform_store_insert_child(&store, childA);
+    // inserted right after childA, childB and otherRoot moved
+    childB++;
+    otherRoot++;
+    printf("indices: %i %i %i %i %i (expected 0 1 2 3 4)\n", root, childA, grandChild, childB, otherRoot);
+    printf("parents: %i %i %i %i %i (expected -1 0 1 0 -1)\n", store.parents[0], store.parents[1], store.parents[2], store.parents[3], store.parents[4]);
+    printf("subtree sizes: %i %i %i %i %i (expected 4 2 1 1 1)\n", store.subtreeSizes[0], store.subtreeSizes[1], store.subtreeSizes[2], store.subtreeSizes[3], store.subtreeSizes[4]);
+    for(int i = 0; i < 5; i++) transform_store_set(&store, i, tr[i][0], tr[i][1], tr[i][2], tr[i][3]);
+    transform_store_compose(&store);
+    transform_store_clear_dirty(&store);
+    printf("moving the root, expects 0 1 2 3 to be recomputed\n");
+    tr[0][0][0] += 2;
+    transform_store_set(&store, root, tr[0][0], tr[0][1], tr[0][2], tr[0][3]);
+    transform_store_compose(&store);
+    printf("dirty after compose: %i %i %i %i %i\n", transform_store_is_dirty(&store, 0), transform_store_is_dirty(&store, 1),
+        transform_store_is_dirty(&store, 2), transform_store_is_dirty(&store, 3), transform_store_is_dirty(&store, 4));
+    float locals[3][16], world[16], tmpWorld[16];
+    for(int i = 0; i < 3; i++) referenceTransform(tr[i][0], tr[i][1], tr[i][2], tr[i][3], locals[i]);
+    transform_multiply(locals[0], locals[1], tmpWorld);
+    transform_multiply(tmpWorld, locals[2], world);
+    printf("world matrix of the grand child: %s\n", matrixDifference(transform_store_model(&store, grandChild), world) < 1e-4 ? "ok" : "WRONG");
+    transform_store_free(&store);
+
+    printf("\ntesting bvh\n1: transforming a box rotated 45 degrees around z\n");
+    BvhBox unit = {{-1, -1, -1}, {1, 1, 1}};
+    float rotated[16];
+    float zero3[3] = {0, 0, 0}, one3[3] = {1, 1, 1}, rot45[3] = {0, 0, M_PI / 4};
+    transform_compose(zero3, one3, rot45, zero3, rotated);
+    BvhBox worldBox;
+    bvh_box_transform(&unit, rotated, &worldBox);
+    printf("x extent: %.3f %.3f (expected -1.414 1.414)\n", worldBox.min[0], worldBox.max[0]);
+    printf("\n2: culling 1000 unit boxes on a line against an orthographic frustum covering x in [-10, 10]\n");
+    struct Bvh bvh;
+    bvh_init(&bvh);
+    for(int i = 0; i < 1000; i++) {
+        BvhBox b = {{i - 500 - 0.5f, -0.5f, -5.5f}, {i - 500 + 0.5f, 0.5f, -4.5f}};
+        bvh_set(&bvh, i, &b);
+    }
+    // glm_ortho(-10, 10, -1, 1, 0.1, 100), column major
+    float ortho[16] = {0.1f, 0, 0, 0, 0, 1, 0, 0, 0, 0, -2 / 99.9f, 0, 0, 0, -100.1f / 99.9f, 1};
+    float planes[6][4];
+    frustum_planes_from_matrix(ortho, planes);
+    int visibleItems[1000];
+    int visibleCount = bvh_query_planes(&bvh, planes, visibleItems);
+    int wrongItems = 0;
+    for(int i = 0; i < visibleCount; i++) {
+        if(visibleItems[i] < 490 || visibleItems[i] > 510) wrongItems++;
+    }
+    printf("visible: %i (expected 21), outside of the frustum: %i\n", visibleCount, wrongItems);
+    printf("moving box 0 to the center (refit)\n");
+    BvhBox center = {{-0.5f, -0.5f, -5.5f}, {0.5f, 0.5f, -4.5f}};
+    bvh_set(&bvh, 0, &center);
+    visibleCount = bvh_query_planes(&bvh, planes, visibleItems);
+    bool found = false;
+    for(int i = 0; i < visibleCount; i++) found |= visibleItems[i] == 0;
+    printf("visible: %i (expected 22), box 0 visible: %i\n", visibleCount, found);
+    bvh_free(&bvh);
+
+    printf("\ntesting meshes\n1: importing a cube (8 positions, 4 texcoords, 6 normals, 6 quads)\n");
+    const char* cubeObj =
+        "# cube\n"
+        "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\nv -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+        "vn 0 0 -1\nvn 0 0 1\nvn 0 -1 0\nvn 0 1 0\nvn -1 0 0\nvn 1 0 0\n"
+        "o cube\n"
+        "f 1/1/1 4/4/1 3/3/1 2/2/1\n"
+        "f 5/1/2 6/2/2 7/3/2 8/4/2\n"
+        "f 1/1/3 2/2/3 6/3/3 5/4/3\n"
+        "f 4/1/4 8/2/4 7/3/4 3/4/4\n"
+        "f 1/1/5 5/2/5 8/3/5 4/4/5\n"
+        // relative indices, the same corners as 2/1/6 3/2/6 7/3/6 6/4/6
+        "f -7/-4/-1 -6/-3/-1 -2/-2/-1 -3/-1/-1\n";
+    FILE* objFile = fopen("build/test_cube.obj", "w");
+    fputs(cubeObj, objFile);
+    fclose(objFile);
+    struct MeshData cube;
+    int imported = mesh_data_import_obj(&cube, "build/test_cube.obj");
+    printf("result: %i, vertices: %i (expected 24), indices: %i (expected 36)\n", imported, cube.vertexCount, cube.indexCount);
+    printf("bounds: %.0f %.0f %.0f to %.0f %.0f %.0f\n", cube.min[0], cube.min[1], cube.min[2], cube.max[0], cube.max[1], cube.max[2]);
+    int sharedCorners = 0;
+    for(int i = 0; i < cube.vertexCount; i++) {
+        for(int j = i + 1; j < cube.vertexCount; j++) sharedCorners += memcmp(&cube.vertices[i], &cube.vertices[j], sizeof(MeshVertex)) == 0;
+    }
+    printf("duplicated vertices: %i\n", sharedCorners);
+    FILE* quadFile = fopen("build/test_quad.obj", "w");
+    fputs("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3\nf 1 3 4\n", quadFile);
+    fclose(quadFile);
+    struct MeshData quad;
+    mesh_data_import_obj(&quad, "build/test_quad.obj");
+    printf("quad as two triangles sharing an edge, vertices: %i (expected 4), indices: %i (expected 6)\n", quad.vertexCount, quad.indexCount);
+    mesh_data_free(&quad);
+    remove("build/test_quad.obj");
+    printf("\n2: writing it as a mesh file and mapping it back\n");
+    mesh_data_write(&cube, "build/test_cube.mesh");
+    struct MeshData mapped;
+    int mappedResult = mesh_data_map(&mapped, "build/test_cube.mesh");
+    bool sameData = mappedResult == 0 && mapped.vertexCount == cube.vertexCount && mapped.indexCount == cube.indexCount
+        && memcmp(mapped.vertices, cube.vertices, cube.vertexCount * sizeof(MeshVertex)) == 0
+        && memcmp(mapped.indices, cube.indices, cube.indexCount * sizeof(unsigned int)) == 0;
+    printf("result: %i, same data: %s\n", mappedResult, sameData ? "ok" : "WRONG");
+    mesh_data_free(&mapped);
+    printf("writing it with an index past the vertices then with a partial triangle, and mapping them\n");
+    unsigned int savedIndex = cube.indices[4];
+    cube.indices[4] = cube.vertexCount;
+    mesh_data_write(&cube, "build/test_cube.mesh");
+    printf("result: %i (expected -1)\n", mesh_data_map(&mapped, "build/test_cube.mesh"));
+    cube.indices[4] = savedIndex;
+    cube.indexCount--;
+    mesh_data_write(&cube, "build/test_cube.mesh");
+    printf("result: %i (expected -1)\n", mesh_data_map(&mapped, "build/test_cube.mesh"));
+    cube.indexCount++;
+    printf("\n3: mapping the obj file as a mesh file, and importing an out of range face\n");
+    printf("result: %i (expected -1)\n", mesh_data_map(&mapped, "build/test_cube.obj"));
+    objFile = fopen("build/test_cube.obj", "w");
+    fputs("v 0 0 0\nv 1 0 0\nf 1 2 3\n", objFile);
+    fclose(objFile);
+    printf("result: %i (expected -1)\n", mesh_data_import_obj(&mapped, "build/test_cube.obj"));
+    printf("\n4: optimizing a 64x64 quads grid whose triangles are shuffled\n");
+    struct MeshData grid;
+    int side = 65;
+    grid.vertexCount = side * side;
+    grid.indexCount = 64 * 64 * 6;
+    grid.vertices = calloc(grid.vertexCount, sizeof(MeshVertex));
+    grid.indices = malloc(grid.indexCount * sizeof(unsigned int));
+    grid.mapping = NULL;
+    // the x of every vertex is its original index, to check the triangles afterwards
+    for(int i = 0; i < grid.vertexCount; i++) grid.vertices[i].position[0] = i;
+    for(int y = 0; y < 64; y++) {
+        for(int x = 0; x < 64; x++) {
+            unsigned int v = y * side + x;
+            unsigned int quadIndices[6] = {v, v + 1, v + side, v + 1, v + side + 1, v + side};
+            memcpy(grid.indices + (y * 64 + x) * 6, quadIndices, sizeof(quadIndices));
+        }
+    }
+    srand(42);
+    for(int t = grid.indexCount / 3 - 1; t > 0; t--) {
+        int other = rand() % (t + 1);
+        unsigned int tmp[3];
+        memcpy(tmp, grid.indices + t * 3, sizeof(tmp));
+        memcpy(grid.indices + t * 3, grid.indices + other * 3, sizeof(tmp));
+        memcpy(grid.indices + other * 3, tmp, sizeof(tmp));
+    }
+    // every triangle as the original indices of its corners, rotated so the smallest comes first (keeps the winding)
+    long triangleSum = 0, triangleProducts = 0;
+    for(int t = 0; t < grid.indexCount / 3; t++) {
+        unsigned int* tri = grid.indices + t * 3;
+        int r = tri[1] < tri[0] && tri[1] < tri[2] ? 1 : tri[2] < tri[0] && tri[2] < tri[1] ? 2 : 0;
+        long a = tri[r], b = tri[(r + 1) % 3], c = tri[(r + 2) % 3];
+        triangleSum += a * 31 * 31 + b * 31 + c;
+        triangleProducts += (a + 1) * (b + 7) % 1000003 * (c + 13) % 1000003;
+    }
+    float acmrBefore, acmrAfter;
+    mesh_data_optimize(&grid, &acmrBefore, &acmrAfter);
+    printf("acmr: %.3f -> %.3f, %s\n", acmrBefore, acmrAfter, acmrAfter < acmrBefore * 0.5 ? "better" : "NOT BETTER");
+    long optimizedSum = 0, optimizedProducts = 0;
+    bool fetchOrdered = true;
+    int highest = -1;
+    for(int t = 0; t < grid.indexCount / 3; t++) {
+        unsigned int* tri = grid.indices + t * 3;
+        long original[3];
+        for(int i = 0; i < 3; i++) {
+            original[i] = grid.vertices[tri[i]].position[0];
+            // vertices are first used in order
+            if((int) tri[i] > highest + 1) fetchOrdered = false;
+            if((int) tri[i] > highest) highest = tri[i];
+        }
+        int r = original[1] < original[0] && original[1] < original[2] ? 1 : original[2] < original[0] && original[2] < original[1] ? 2 : 0;
+        long a = original[r], b = original[(r + 1) % 3], c = original[(r + 2) % 3];
+        optimizedSum += a * 31 * 31 + b * 31 + c;
+        optimizedProducts += (a + 1) * (b + 7) % 1000003 * (c + 13) % 1000003;
+    }
+    printf("same triangles: %s, vertices in first use order: %s\n", triangleSum == optimizedSum && triangleProducts == optimizedProducts ? "ok" : "WRONG", fetchOrdered ? "ok" : "WRONG");
+    mesh_data_free(&grid);
+    printf("\n5: simplifying a unit sphere (32 rings of 64 segments) to a quarter of its triangles, then a flat 32x32 quads grid\n");
+    int rings = 32, segments = 64;
+    int sphereVertexCount = 2 + (rings - 1) * segments;
+    float (*sphere)[3] = calloc(sphereVertexCount, sizeof(float[3]));
+    // the poles
+    sphere[0][1] = 1;
+    sphere[1][1] = -1;
+    for(int r = 1; r < rings; r++) {
+        float theta = M_PI * r / rings;
+        for(int s = 0; s < segments; s++) {
+            float phi = 2 * M_PI * s / segments;
+            float* p = sphere[2 + (r - 1) * segments + s];
+            p[0] = sinf(theta) * cosf(phi);
+            p[1] = cosf(theta);
+            p[2] = sinf(theta) * sinf(phi);
+        }
+    }
+    int sphereIndexCount = segments * (rings - 1) * 6;
+    unsigned int* sphereIndices = malloc(sphereIndexCount * sizeof(unsigned int));
+    int written = 0;
+    for(int s = 0; s < segments; s++) {
+        unsigned int a = 2 + s, b = 2 + (s + 1) % segments;
+        unsigned int top[3] = {0, b, a};
+        unsigned int bottom[3] = {1, a + (rings - 2) * segments, b + (rings - 2) * segments};
+        memcpy(sphereIndices + written, top, sizeof(top));
+        memcpy(sphereIndices + written + 3, bottom, sizeof(bottom));
+        written += 6;
+        for(int r = 1; r < rings - 1; r++) {
+            unsigned int c = a + segments, d = b + segments;
+            unsigned int quadIndices[6] = {a, b, c, b, d, c};
+            memcpy(sphereIndices + written, quadIndices, sizeof(quadIndices));
+            written += 6;
+            a = c;
+            b = d;
+        }
+    }
+    unsigned int* simplified = malloc(sphereIndexCount * sizeof(unsigned int));
+    float simplifyError;
+    int simplifiedCount = mesh_simplify((float*) sphere, sizeof(float[3]), sphereVertexCount, sphereIndices, written, written / 4, 1, simplified, &simplifyError);
+    bool validTriangles = true;
+    for(int i = 0; i < simplifiedCount; i += 3) {
+        unsigned int* tri = simplified + i;
+        validTriangles &= tri[0] < (unsigned int) sphereVertexCount && tri[1] < (unsigned int) sphereVertexCount && tri[2] < (unsigned int) sphereVertexCount;
+        validTriangles &= tri[0] != tri[1] && tri[1] != tri[2] && tri[0] != tri[2];
+    }
+    printf("triangles: %i -> %i, %s, error: %s (%.4f), valid triangles: %s\n", written / 3, simplifiedCount / 3,
+        simplifiedCount <= written / 4 ? "ok" : "TOO MANY", simplifyError > 0 && simplifyError < 0.05 ? "ok" : "WRONG", simplifyError, validTriangles ? "ok" : "WRONG");
+    simplifiedCount = mesh_simplify((float*) sphere, sizeof(float[3]), sphereVertexCount, sphereIndices, written, 0, 0.001, simplified, &simplifyError);
+    printf("with a tiny max error: %i triangles left, %s\n", simplifiedCount / 3, simplifiedCount > written / 2 ? "ok" : "TOO FEW");
+    free(sphere);
+    free(sphereIndices);
+    free(simplified);
+    float (*flat)[3] = calloc(33 * 33, sizeof(float[3]));
+    for(int i = 0; i < 33 * 33; i++) {
+        flat[i][0] = i % 33;
+        flat[i][2] = i / 33;
+    }
+    unsigned int* flatIndices = malloc(32 * 32 * 6 * sizeof(unsigned int));
+    for(int y = 0; y < 32; y++) {
+        for(int x = 0; x < 32; x++) {
+            unsigned int v = y * 33 + x;
+            unsigned int quadIndices[6] = {v, v + 33, v + 1, v + 1, v + 33, v + 34};
+            memcpy(flatIndices + (y * 32 + x) * 6, quadIndices, sizeof(quadIndices));
+        }
+    }
+    simplified = malloc(32 * 32 * 6 * sizeof(unsigned int));
+    simplifiedCount = mesh_simplify((float*) flat, sizeof(float[3]), 33 * 33, flatIndices, 32 * 32 * 6, 0, 0.001, simplified, &simplifyError);
+    // only the 128 border vertices can't move
+    printf("grid triangles: %i -> %i, %s, error: %.4f\n", 32 * 32 * 2, simplifiedCount / 3, simplifiedCount / 3 <= 256 ? "ok" : "TOO MANY", simplifyError);
+    free(flat);
+    free(flatIndices);
+    free(simplified);
+    mesh_data_free(&cube);
+    remove("build/test_cube.obj");
+    remove("build/test_cube.mesh");
+
+    printf("\ntesting shader cache\n1: keys\n");
+    unsigned long long keyA = shader_cache_hash_string(shader_cache_hash_string(SHADER_CACHE_HASH_SEED, "ab"), "c");
+    unsigned long long keyB = shader_cache_hash_string(shader_cache_hash_string(SHADER_CACHE_HASH_SEED, "a"), "bc");
+    unsigned long long keyC = shader_cache_hash_string(shader_cache_hash_string(SHADER_CACHE_HASH_SEED, "ab"), "c");
+    printf("same strings: %s, split differently: %s\n", keyA == keyC ? "same key" : "WRONG", keyA != keyB ? "different keys" : "WRONG");
+    printf("\n2: storing a binary and loading it back\n");
+    const char binaryData[] = "not really a program binary";
+    int stored = shader_cache_store("build/test_shader_cache", keyA, 0x8e7c, binaryData, sizeof(binaryData));
+    unsigned int binaryFormat;
+    void* loadedBinary;
+    int loadedLength;
+    int loadedResult = shader_cache_load("build/test_shader_cache", keyA, &binaryFormat, &loadedBinary, &loadedLength);
+    bool sameBinary = loadedResult == 0 && binaryFormat == 0x8e7c && loadedLength == sizeof(binaryData) && memcmp(loadedBinary, binaryData, loadedLength) == 0;
+    printf("stored: %i, loaded: %i, same binary and format: %s\n", stored, loadedResult, sameBinary ? "ok" : "WRONG");
+    if(loadedResult == 0) free(loadedBinary);
+    printf("\n3: missing entry (silent), then an entry renamed to another key\n");
+    printf("result: %i (expected -1)\n", shader_cache_load("build/test_shader_cache", keyB, &binaryFormat, &loadedBinary, &loadedLength));
+    char entryPath[64], renamedPath[64];
+    sprintf(entryPath, "build/test_shader_cache/%016llx.bin", keyA);
+    sprintf(renamedPath, "build/test_shader_cache/%016llx.bin", keyB);
+    rename(entryPath, renamedPath);
+    printf("result: %i (expected -1)\n", shader_cache_load("build/test_shader_cache", keyB, &binaryFormat, &loadedBinary, &loadedLength));
+    remove(renamedPath);
+    remove("build/test_shader_cache");
+    printf("\n4: adding defines to a source\n");
+    char* variantDefines[] = {"SHADOWS", "LIGHTS 4"};
+    char* variant = shader_source_with_defines("#version 420\nvoid main() {}\n", variantDefines, 2);
+    const char* expectedVariant = "#version 420\n#define SHADOWS\n#define LIGHTS 4\n#line 2\nvoid main() {}\n";
+    printf("%s", variant);
+    printf("with a #version line: %s\n", strcmp(variant, expectedVariant) == 0 ? "ok" : "WRONG");
+    free(variant);
+    variant = shader_source_with_defines("void main() {}\n", variantDefines, 1);
+    printf("without: %s\n", strcmp(variant, "#define SHADOWS\n#line 1\nvoid main() {}\n") == 0 ? "ok" : "WRONG");
+    free(variant);
+    free_interned_strings();
 }
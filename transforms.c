@@ -0,0 +1,243 @@
+#include "transforms.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// internal, resize a 16 bytes aligned float array (for aligned SIMD loads), new elements set to value
+float* growTransformArray(float* array, int oldCount, int newCount, int components, float value) {
+    float* grown = aligned_alloc(16, newCount * components * sizeof(float));
+    if(array != NULL) {
+        memcpy(grown, array, oldCount * components * sizeof(float));
+        free(array);
+    }
+    for(int i = oldCount * components; i < newCount * components; i++) grown[i] = value;
+    return grown;
+}
+
+void transform_store_init(struct TransformStore *store) {
+    memset(store, 0, sizeof(struct TransformStore));
+    store->viewProjectionDirty = true;
+}
+
+int transform_store_add(struct TransformStore *store) {
+    if(store->size == store->allocated) {
+        // multiple of 32 so that the dirty bits fill whole ints
+        int allocated = store->allocated > 0 ? store->allocated * 2 : 32;
+        float** zeros[] = {&store->tx, &store->ty, &store->tz, &store->rx, &store->ry, &store->rz, &store->ox, &store->oy, &store->oz};
+        float** ones[] = {&store->sx, &store->sy, &store->sz};
+        for(int i = 0; i < 9; i++) *zeros[i] = growTransformArray(*zeros[i], store->allocated, allocated, 1, 0);
+        for(int i = 0; i < 3; i++) *ones[i] = growTransformArray(*ones[i], store->allocated, allocated, 1, 1);
+        store->locals = growTransformArray(store->locals, store->allocated, allocated, 16, 0);
+        store->models = growTransformArray(store->models, store->allocated, allocated, 16, 0);
+        store->parents = realloc(store->parents, allocated * sizeof(int));
+        store->subtreeSizes = realloc(store->subtreeSizes, allocated * sizeof(int));
+        store->dirty = realloc(store->dirty, allocated / 32 * sizeof(unsigned int));
+        memset(store->dirty + store->allocated / 32, 0, (allocated - store->allocated) / 32 * sizeof(unsigned int));
+        store->allocated = allocated;
+    }
+    int index = store->size++;
+    store->parents[index] = -1;
+    store->subtreeSizes[index] = 1;
+    transform_store_mark_dirty(store, index);
+    return index;
+}
+
+int transform_store_insert_child(struct TransformStore *store, int parent) {
+    int index = parent + store->subtreeSizes[parent];
+    // grows the arrays if needed, the new element is then moved to index
+    transform_store_add(store);
+    int moved = store->size - 1 - index;
+    if(moved > 0) {
+        float* components[] = {
+            store->tx, store->ty, store->tz, store->sx, store->sy, store->sz,
+            store->rx, store->ry, store->rz, store->ox, store->oy, store->oz
+        };
+        float identity[12] = {0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0};
+        for(int c = 0; c < 12; c++) {
+            memmove(components[c] + index + 1, components[c] + index, moved * sizeof(float));
+            components[c][index] = identity[c];
+        }
+        memmove(store->parents + index + 1, store->parents + index, moved * sizeof(int));
+        memmove(store->subtreeSizes + index + 1, store->subtreeSizes + index, moved * sizeof(int));
+        for(int i = index + 1; i < store->size; i++) {
+            if(store->parents[i] >= index) store->parents[i]++;
+        }
+        // matrices are recomputed rather than moved, everything after index has to be marked anyway
+        for(int i = index; i < store->size; i++) transform_store_mark_dirty(store, i);
+    }
+    store->parents[index] = parent;
+    store->subtreeSizes[index] = 1;
+    for(int p = parent; p >= 0; p = store->parents[p]) store->subtreeSizes[p]++;
+    return index;
+}
+
+bool transform_store_set(struct TransformStore *store, int index, const float translation[3], const float scale[3], const float rotation[3], const float origin[3]) {
+    float* components[12] = {
+        &store->tx[index], &store->ty[index], &store->tz[index],
+        &store->sx[index], &store->sy[index], &store->sz[index],
+        &store->rx[index], &store->ry[index], &store->rz[index],
+        &store->ox[index], &store->oy[index], &store->oz[index]
+    };
+    const float* values[4] = {translation, scale, rotation, origin};
+    bool changed = false;
+    for(int i = 0; i < 12; i++) {
+        float v = values[i / 3][i % 3];
+        if(*components[i] != v) {
+            *components[i] = v;
+            changed = true;
+        }
+    }
+    if(changed) transform_store_mark_dirty(store, index);
+    return changed;
+}
+
+void transform_store_mark_dirty(struct TransformStore *store, int index) {
+    store->dirty[index / 32] |= 1u << (index % 32);
+}
+
+bool transform_store_is_dirty(struct TransformStore *store, int index) {
+    return store->dirty[index / 32] & (1u << (index % 32));
+}
+
+void transform_compose(const float t[3], const float s[3], const float r[3], const float o[3], float out[16]) {
+    float sa = sinf(r[0]), ca = cosf(r[0]);
+    float sb = sinf(r[1]), cb = cosf(r[1]);
+    float sc = sinf(r[2]), cc = cosf(r[2]);
+    // rotate_x * rotate_y * rotate_z, R[row][column]
+    float R[3][3] = {
+        {cb * cc,                 -cb * sc,                 sb},
+        {sa * sb * cc + ca * sc,  -sa * sb * sc + ca * cc,  -sa * cb},
+        {-ca * sb * cc + sa * sc, ca * sb * sc + sa * cc,   ca * cb}
+    };
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) out[j * 4 + i] = s[i] * R[i][j];
+        // the origin is moved by the rotation, then everything is scaled and translated
+        float ro = R[i][0] * o[0] + R[i][1] * o[1] + R[i][2] * o[2];
+        out[12 + i] = t[i] + s[i] * (o[i] - ro);
+        out[i * 4 + 3] = 0;
+    }
+    out[15] = 1;
+}
+
+void transform_multiply(const float a[16], const float b[16], float out[16]) {
+#ifdef __SSE__
+    __m128 c0 = _mm_loadu_ps(a + 0);
+    __m128 c1 = _mm_loadu_ps(a + 4);
+    __m128 c2 = _mm_loadu_ps(a + 8);
+    __m128 c3 = _mm_loadu_ps(a + 12);
+    for(int j = 0; j < 4; j++) {
+        __m128 col = _mm_mul_ps(c0, _mm_set1_ps(b[j * 4 + 0]));
+        col = _mm_add_ps(col, _mm_mul_ps(c1, _mm_set1_ps(b[j * 4 + 1])));
+        col = _mm_add_ps(col, _mm_mul_ps(c2, _mm_set1_ps(b[j * 4 + 2])));
+        col = _mm_add_ps(col, _mm_mul_ps(c3, _mm_set1_ps(b[j * 4 + 3])));
+        _mm_storeu_ps(out + j * 4, col);
+    }
+#else
+    for(int j = 0; j < 4; j++) {
+        for(int i = 0; i < 4; i++) {
+            out[j * 4 + i] = a[i] * b[j * 4 + 0] + a[4 + i] * b[j * 4 + 1] + a[8 + i] * b[j * 4 + 2] + a[12 + i] * b[j * 4 + 3];
+        }
+    }
+#endif
+}
+
+// internal, dirty bits of the group of TRANSFORM_STORE_GROUP elements starting at base
+unsigned int dirtyGroupBits(struct TransformStore *store, int base) {
+    return (store->dirty[base / 32] >> (base % 32)) & ((1u << TRANSFORM_STORE_GROUP) - 1);
+}
+
+#ifdef __SSE__
+// internal, same as transform_compose but for the 4 elements starting at base, one per lane
+void composeGroup(struct TransformStore *store, int base) {
+    // no SIMD sin / cos in SSE, those are done per element
+    float sines[3][4], cosines[3][4];
+    float* angles[3] = {store->rx + base, store->ry + base, store->rz + base};
+    for(int a = 0; a < 3; a++) {
+        for(int e = 0; e < 4; e++) {
+            sines[a][e] = sinf(angles[a][e]);
+            cosines[a][e] = cosf(angles[a][e]);
+        }
+    }
+    __m128 sa = _mm_loadu_ps(sines[0]), ca = _mm_loadu_ps(cosines[0]);
+    __m128 sb = _mm_loadu_ps(sines[1]), cb = _mm_loadu_ps(cosines[1]);
+    __m128 sc = _mm_loadu_ps(sines[2]), cc = _mm_loadu_ps(cosines[2]);
+    __m128 sasb = _mm_mul_ps(sa, sb);
+    __m128 casb = _mm_mul_ps(ca, sb);
+    __m128 R[3][3];
+    R[0][0] = _mm_mul_ps(cb, cc);
+    R[0][1] = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cb, sc));
+    R[0][2] = sb;
+    R[1][0] = _mm_add_ps(_mm_mul_ps(sasb, cc), _mm_mul_ps(ca, sc));
+    R[1][1] = _mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc));
+    R[1][2] = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sa, cb));
+    R[2][0] = _mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc));
+    R[2][1] = _mm_add_ps(_mm_mul_ps(casb, sc), _mm_mul_ps(sa, cc));
+    R[2][2] = _mm_mul_ps(ca, cb);
+    __m128 t[3] = {_mm_load_ps(store->tx + base), _mm_load_ps(store->ty + base), _mm_load_ps(store->tz + base)};
+    __m128 s[3] = {_mm_load_ps(store->sx + base), _mm_load_ps(store->sy + base), _mm_load_ps(store->sz + base)};
+    __m128 o[3] = {_mm_load_ps(store->ox + base), _mm_load_ps(store->oy + base), _mm_load_ps(store->oz + base)};
+    // rows 0 to 3 of each column, one lane per element
+    __m128 cols[4][4];
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) cols[j][i] = _mm_mul_ps(s[i], R[i][j]);
+        __m128 ro = _mm_add_ps(_mm_add_ps(_mm_mul_ps(R[i][0], o[0]), _mm_mul_ps(R[i][1], o[1])), _mm_mul_ps(R[i][2], o[2]));
+        cols[3][i] = _mm_add_ps(t[i], _mm_mul_ps(s[i], _mm_sub_ps(o[i], ro)));
+    }
+    cols[0][3] = cols[1][3] = cols[2][3] = _mm_setzero_ps();
+    cols[3][3] = _mm_set1_ps(1);
+    float* out = store->locals + base * 16;
+    for(int j = 0; j < 4; j++) {
+        // from one lane per element to one register per element
+        _MM_TRANSPOSE4_PS(cols[j][0], cols[j][1], cols[j][2], cols[j][3]);
+        for(int e = 0; e < 4; e++) _mm_store_ps(out + e * 16 + j * 4, cols[j][e]);
+    }
+}
+#else
+void composeGroup(struct TransformStore *store, int base) {
+    for(int e = base; e < base + TRANSFORM_STORE_GROUP; e++) {
+        float t[3] = {store->tx[e], store->ty[e], store->tz[e]};
+        float s[3] = {store->sx[e], store->sy[e], store->sz[e]};
+        float r[3] = {store->rx[e], store->ry[e], store->rz[e]};
+        float o[3] = {store->ox[e], store->oy[e], store->oz[e]};
+        transform_compose(t, s, r, o, store->locals + e * 16);
+    }
+}
+#endif
+
+void transform_store_compose(struct TransformStore *store) {
+    for(int base = 0; base < store->size; base += TRANSFORM_STORE_GROUP) {
+        // the whole group is recomposed as soon as one of them is dirty, it costs the same
+        if(dirtyGroupBits(store, base)) composeGroup(store, base);
+    }
+    // parents come first, so their world matrix (and dirty bit) is always final when reaching a child
+    for(int i = 0; i < store->size; i++) {
+        int parent = store->parents[i];
+        if(parent >= 0 && transform_store_is_dirty(store, parent)) transform_store_mark_dirty(store, i);
+        if(!transform_store_is_dirty(store, i)) continue;
+        if(parent < 0) {
+            memcpy(store->models + i * 16, store->locals + i * 16, 16 * sizeof(float));
+        } else {
+            transform_multiply(store->models + parent * 16, store->locals + i * 16, store->models + i * 16);
+        }
+    }
+}
+
+void transform_store_clear_dirty(struct TransformStore *store) {
+    memset(store->dirty, 0, store->allocated / 32 * sizeof(unsigned int));
+}
+
+void transform_store_free(struct TransformStore *store) {
+    float* arrays[] = {
+        store->tx, store->ty, store->tz, store->sx, store->sy, store->sz,
+        store->rx, store->ry, store->rz, store->ox, store->oy, store->oz,
+        store->locals, store->models
+    };
+    for(int i = 0; i < 14; i++) free(arrays[i]);
+    free(store->parents);
+    free(store->subtreeSizes);
+    free(store->dirty);
+    memset(store, 0, sizeof(struct TransformStore));
+}
@@ -0,0 +1,61 @@
+#ifndef _TRANSFORMS_H
+#define _TRANSFORMS_H
+#include <stdbool.h>
+
+// elements are composed by groups of that many at once (SSE lanes), arrays are padded to it
+#define TRANSFORM_STORE_GROUP 4
+
+// translation, scale, rotation (euler, applied x then y then z) and origin of many elements,
+// stored structure of arrays so that their model matrices can be composed a group at a time.
+// matrices are 16 floats, column major (same layout as cglm's mat4).
+// elements form a hierarchy stored depth first: the subtree of an element is the subtreeSizes[i]
+// elements starting at i, so a parent always comes before its children and a single pass in
+// order computes every world matrix. an element is only recomposed when its transforms (or
+// the world matrix of its parent) changed since the last update
+struct TransformStore {
+    int size;
+    int allocated;
+    // one array per component, allocated elements past size hold the identity
+    float *tx, *ty, *tz;
+    float *sx, *sy, *sz;
+    float *rx, *ry, *rz;
+    float *ox, *oy, *oz;
+    // parent index (-1 for roots), always lower than the element's own index
+    int *parents;
+    // number of elements in the subtree of each element, itself included
+    int *subtreeSizes;
+    // transforms relative to the parent, 16 floats per element
+    float *locals;
+    // world matrices (parent's world * local), 16 floats per element
+    float *models;
+    // one bit per element, set when its model needs to be recomputed, spreads to the subtree on compose
+    unsigned int *dirty;
+    // set when the view projection changed, for the owner of the store to know it has to send it again
+    bool viewProjectionDirty;
+};
+
+void transform_store_init(struct TransformStore *store);
+// add a root element with identity transforms, returns its index
+int transform_store_add(struct TransformStore *store);
+// add an element with identity transforms at the end of the subtree of parent, returns its index.
+// every element from that index on is moved one index further (their parents are updated)
+int transform_store_insert_child(struct TransformStore *store, int parent);
+// set the transforms of an element, only marking it dirty if they are different from the stored ones
+bool transform_store_set(struct TransformStore *store, int index, const float translation[3], const float scale[3], const float rotation[3], const float origin[3]);
+void transform_store_mark_dirty(struct TransformStore *store, int index);
+bool transform_store_is_dirty(struct TransformStore *store, int index);
+// recompose the local matrix of every dirty element, then the world matrix of every dirty element
+// and of their subtrees (which get marked dirty too)
+void transform_store_compose(struct TransformStore *store);
+// call once the changes of the update have been used
+void transform_store_clear_dirty(struct TransformStore *store);
+void transform_store_free(struct TransformStore *store);
+static inline float* transform_store_model(struct TransformStore *store, int index) {
+    return store->models + index * 16;
+}
+
+// closed form of translate(t) * scale(s) * translate(o) * rotate_x * rotate_y * rotate_z * translate(-o)
+void transform_compose(const float translation[3], const float scale[3], const float rotation[3], const float origin[3], float out[16]);
+// out = a * b, out can't be a or b
+void transform_multiply(const float a[16], const float b[16], float out[16]);
+#endif
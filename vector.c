@@ -14,6 +14,10 @@ void vector_init(struct Vector *vec, int initSize, size_t dataSize) {
     vec->data_size = dataSize;
 }
 
+void vector_reserve(struct Vector *vec, int capacity) {
+    vec->data = vector_grow_storage(vec->data, &vec->allocated, capacity, vec->data_size);
+}
+
 void vector_set(struct Vector *vec, void* data, unsigned int index) {
     if(index < vec->size)
         memcpy(vec->data + index * vec->data_size, data, vec->data_size);
@@ -22,27 +26,22 @@ void vector_set(struct Vector *vec, void* data, unsigned int index) {
 }
 
 void vector_push(struct Vector *vec, void* data) {
-    // if used size is larger than allocated
-    if(vec->size >= vec->allocated) {
-        // reallocated double the size
-        vec->data = realloc(vec->data, (vec->allocated*=2) * vec->data_size);
-    } 
+    // grows geometrically, same as the typed vectors
+    vector_reserve(vec, vec->size + 1);
     // copy the data to push, to manually allocated memory to avoid dangeling pointers
     memcpy(vec->data + (vec->size++) * vec->data_size, data, vec->data_size);
 }
 
 void vector_push_array(struct Vector *vec, void* array, int arrayLength) {
-    if(arrayLength + vec->size > vec->allocated) {
-        vec->data = realloc(vec->data, (vec->allocated = vec->size + arrayLength + 1) * vec->data_size);
-    }
+    // grow geometrically as well, growing to the exact size makes repeated appends quadratic
+    vector_reserve(vec, vec->size + arrayLength);
     memcpy(vec->data + vec->size * vec->data_size, array, arrayLength * vec->data_size);
     vec->size += arrayLength;
 }
 
 void vector_insert_before(struct Vector *vec, void* data, int index) {
     // same as in puhs
-    if(vec->size >= vec->allocated)
-        vec->data = realloc(vec->data, (vec->allocated*=2) * vec->data_size);
+    vector_reserve(vec, vec->size + 1);
     if(index < vec->size)
         memmove(vec->data + (index + 1) * vec->data_size, vec->data + index * vec->data_size, (vec->size - index) * vec->data_size);
     vec->size++;
@@ -98,3 +97,59 @@ void vector_print_as_int(struct Vector vec) {
 void vector_free(struct Vector vec) {
     free(vec.data);
 }
+
+void small_vector_init(struct SmallVector *vec, size_t dataSize) {
+    vec->size = 0;
+    vec->data_size = dataSize;
+    vec->heap = NULL;
+    // as many elements as the inline storage can hold (can be 0 for huge elements)
+    vec->allocated = SMALL_VECTOR_INLINE_BYTES / dataSize;
+}
+
+// internal, make room for at least `needed` elements, moving them to the heap if they don't fit inline anymore
+void small_vector_reserve(struct SmallVector *vec, int needed) {
+    if(needed <= vec->allocated) return;
+    int allocated = vector_grow_capacity(vec->allocated, needed);
+    if(vec->heap == NULL) {
+        // first spill, copy the inline elements over
+        vec->heap = malloc(allocated * vec->data_size);
+        memcpy(vec->heap, vec->inline_storage.bytes, vec->size * vec->data_size);
+    } else {
+        vec->heap = realloc(vec->heap, allocated * vec->data_size);
+    }
+    vec->allocated = allocated;
+}
+
+void small_vector_set(struct SmallVector *vec, void* data, unsigned int index) {
+    if(index < vec->size)
+        memcpy(small_vector_get_pointer_to(vec, index), data, vec->data_size);
+    else 
+        printf("WARN: trying to set vector element outside of the vector size.\n");
+}
+
+void small_vector_push(struct SmallVector *vec, void* data) {
+    small_vector_reserve(vec, vec->size + 1);
+    memcpy(small_vector_get_pointer_to(vec, vec->size++), data, vec->data_size);
+}
+
+void small_vector_push_array(struct SmallVector *vec, void* array, int arrayLength) {
+    small_vector_reserve(vec, vec->size + arrayLength);
+    memcpy(small_vector_get_pointer_to(vec, vec->size), array, arrayLength * vec->data_size);
+    vec->size += arrayLength;
+}
+
+void small_vector_splice(struct SmallVector *vec, int start, int length, void* data) {
+    int _length = length >= 0 ? length : vec->size - start;
+    if(_length <= 0) return;
+    char* d = small_vector_data(vec);
+    if(data != NULL) memcpy(data, d + start * vec->data_size, _length * vec->data_size);
+    memmove(d + start * vec->data_size, d + (start + _length) * vec->data_size, ((vec->size -= _length) - start) * vec->data_size);
+}
+
+void small_vector_free(struct SmallVector *vec) {
+    // nothing to do if the elements never left the struct
+    free(vec->heap);
+    vec->heap = NULL;
+    vec->size = 0;
+    vec->allocated = SMALL_VECTOR_INLINE_BYTES / vec->data_size;
+}
@@ -3,6 +3,7 @@
 #ifndef size_t
 #include <stdlib.h>
 #endif
+#include <string.h>
 // used to get elements from vector needs a define because vectors don't have types
 #define vector_get(vectordata, index, type) (((type*)vectordata)[index])
 #define vector_to_array(vector, array, type) \
@@ -12,7 +13,7 @@ for(int _i = 0; _i < vector.size; _i++) { \
 // dynamic custom single type arrays without dangeling pointers
 // (allocate memory for each element and copy data
 // there to make sure pointers always point somewhere)
-// NOTE: pretty inefficient when storing pointers
+// NOTE: pretty inefficient when storing pointers, the typed vectors below (same storage and growth) are better for those
 struct Vector {
     void* data;
     int size;
@@ -24,6 +25,8 @@ struct Vector {
 typedef struct Vector Vector;
 
 void vector_init(struct Vector *vec, int initSize, size_t dataSize);
+// make sure at least `capacity` elements can be stored without reallocating
+void vector_reserve(struct Vector *vec, int capacity);
 void vector_set(struct Vector *vec, void* data, unsigned int index);
 void vector_push(struct Vector *vec, void* data);
 void vector_push_array(struct Vector *vec, void* array, int arrayLength);
@@ -37,4 +40,108 @@ void vector_free(struct Vector vec);
 // print the array as if elements where integers without newlines
 void vector_print_as_int(struct Vector vec);
 void* vector_get_pointer_to(struct Vector vec, int index);
+
+// number of bytes a SmallVector stores inside the struct before spilling to the heap
+#define SMALL_VECTOR_INLINE_BYTES 128
+
+// same as Vector, but the first elements live inside the struct itself, so creating
+// and filling a small vector never touches the heap. elements must be accessed through
+// small_vector_data as the storage moves to the heap once the inline bytes are full.
+// NOTE: can be copied by value (no pointer to itself), but only one copy should be freed
+struct SmallVector {
+    int size;
+    int allocated;
+    size_t data_size;
+    // NULL as long as the elements fit in inline_storage
+    void* heap;
+    // union to get an alignment suitable for any element type
+    union {
+        char bytes[SMALL_VECTOR_INLINE_BYTES];
+        long double _align;
+        void* _alignp;
+    } inline_storage;
+};
+
+typedef struct SmallVector SmallVector;
+
+void small_vector_init(struct SmallVector *vec, size_t dataSize);
+void small_vector_set(struct SmallVector *vec, void* data, unsigned int index);
+void small_vector_push(struct SmallVector *vec, void* data);
+void small_vector_push_array(struct SmallVector *vec, void* array, int arrayLength);
+// same as vector_splice
+void small_vector_splice(struct SmallVector *vec, int start, int length, void* data);
+void small_vector_free(struct SmallVector *vec);
+
+// pointer to the first element, wherever the elements currently are
+static inline void* small_vector_data(struct SmallVector *vec) {
+    return vec->heap != NULL ? vec->heap : vec->inline_storage.bytes;
+}
+
+static inline void* small_vector_get_pointer_to(struct SmallVector *vec, int index) {
+    return (char*)small_vector_data(vec) + index * vec->data_size;
+}
+
+// returns the capacity a vector with `allocated` elements allocated should grow to to hold `needed` elements
+// (doubles until it fits, so that repeated pushes and appends stay amortized O(1))
+static inline int vector_grow_capacity(int allocated, int needed) {
+    int capacity = allocated > 0 ? allocated : 1;
+    while(capacity < needed) capacity *= 2;
+    return capacity;
+}
+
+// storage of every heap vector kind (Vector and the typed ones): data, holding *allocated elements of elementSize
+// bytes, reallocated if it can't hold `needed` of them (*allocated being updated). returns the storage to use
+static inline void* vector_grow_storage(void* data, int* allocated, int needed, size_t elementSize) {
+    if(needed <= *allocated) return data;
+    *allocated = vector_grow_capacity(*allocated, needed);
+    return realloc(data, *allocated * elementSize);
+}
+
+// typed vectors, generated at compile time for a single type so that elements are
+// accessed with plain assignments instead of a data_size multiply and a memcpy.
+// VECTOR_DECLARE(float) declares the type Vector_float and the vector_float_* functions,
+// for types that are not a single identifier (pointers, structs), typedef them first.
+#define VECTOR_DECLARE(type) \
+typedef struct { \
+    type* data; \
+    int size; \
+    int allocated; \
+} Vector_##type; \
+static inline void vector_##type##_init(Vector_##type *vec, int initSize) { \
+    vec->size = 0; \
+    vec->allocated = initSize; \
+    vec->data = calloc(initSize, sizeof(type)); \
+} \
+/* make sure at least `capacity` elements can be stored without reallocating */ \
+static inline void vector_##type##_reserve(Vector_##type *vec, int capacity) { \
+    vec->data = vector_grow_storage(vec->data, &vec->allocated, capacity, sizeof(type)); \
+} \
+static inline void vector_##type##_push(Vector_##type *vec, type value) { \
+    if(vec->size >= vec->allocated) \
+        vector_##type##_reserve(vec, vec->size + 1); \
+    vec->data[vec->size++] = value; \
+} \
+static inline void vector_##type##_push_array(Vector_##type *vec, const type* array, int arrayLength) { \
+    vector_##type##_reserve(vec, vec->size + arrayLength); \
+    memcpy(vec->data + vec->size, array, arrayLength * sizeof(type)); \
+    vec->size += arrayLength; \
+} \
+static inline type vector_##type##_get(const Vector_##type *vec, int index) { \
+    return vec->data[index]; \
+} \
+static inline void vector_##type##_set(Vector_##type *vec, type value, int index) { \
+    vec->data[index] = value; \
+} \
+/* same as vector_splice, without copying the spliced part out */ \
+static inline void vector_##type##_splice(Vector_##type *vec, int start, int length) { \
+    int _length = length >= 0 ? length : vec->size - start; \
+    if(_length <= 0) return; \
+    memmove(vec->data + start, vec->data + start + _length, ((vec->size -= _length) - start) * sizeof(type)); \
+} \
+static inline void vector_##type##_free(Vector_##type vec) { \
+    free(vec.data); \
+}
+
+VECTOR_DECLARE(int)
+VECTOR_DECLARE(float)
 #endif